@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "harness.h"
+#include "host.h"
+#include "onewire_sim.h"
+#include "packed_report.h"
+#include "thermometer.h"
+
+/*
+ * Per-cycle cost of the measurement loop on simulated sensors: bus time, attribute writes of all clusters
+ * and heap allocations, the ROM map of a finished rediscovery pass included. Usage: bench_cycle [sensors] [cycles] [bit errors per million]
+ */
+
+#define BENCH_WARMUP_CYCLES 4
+/* Report Attributes on air: ZCL header, then attribute id and type of the single record */
+#define BENCH_REPORT_OVERHEAD 6
+#define BENCH_SINGLE_REPORT_SIZE (BENCH_REPORT_OVERHEAD + sizeof(int16_t))
+
+int main(int argc, char **argv)
+{
+    uint8_t sensors = argc > 1 ? atoi(argv[1]) : DS18B20_SIM_DEVICES;
+    uint32_t cycles = argc > 2 ? strtoul(argv[2], NULL, 10) : 64;
+    uint32_t ppm    = argc > 3 ? strtoul(argv[3], NULL, 10) : 0;
+
+    if (sensors == 0 || sensors > ONEWIRE_SIM_MAX_DEVICES || cycles == 0)
+    {
+        fprintf(stderr, "usage: %s [1..%d sensors] [cycles] [bit errors per million]\n", argv[0], ONEWIRE_SIM_MAX_DEVICES);
+        return 1;
+    }
+
+    harness_start(sensors);
+    /* Errors start after discovery so every sensor has an endpoint */
+    onewire_sim_set_bit_error_ppm(GPIO_NUM_1, ppm);
+
+    const thermometer_stats_t *stats = thermometer_get_stats();
+    host_zb_stats_t *zb_stats        = host_zb_get_stats();
+
+    /* The first cycles fill the filters and the history buffer, only the steady state is measured */
+    for (uint8_t i = 0; i < BENCH_WARMUP_CYCLES; i++)
+    {
+        if (!harness_run_cycle())
+        {
+            fprintf(stderr, "no measurement cycle ran\n");
+            return 1;
+        }
+    }
+
+    uint32_t allocations   = host_allocations();
+    uint32_t writes        = zb_stats->attribute_writes;
+    uint64_t bus_time_us   = 0;
+    uint32_t max_bus_us    = 0;
+    uint32_t read_failures = 0;
+#if DS18B20_PACKED_REPORT_ENABLE
+    packed_report_stats_t packed = *packed_report_get_stats();
+#endif
+#if DS18B20_ALARM_SEARCH_ENABLE
+    const onewire_sim_stats_t *sim = onewire_sim_get_stats(GPIO_NUM_1);
+    uint32_t window_writes         = sim->writes;
+    uint64_t full_read_us          = 0;
+    uint32_t full_reads            = 0;
+#endif
+
+    for (uint32_t i = 0; i < cycles; i++)
+    {
+        if (!harness_run_cycle())
+        {
+            fprintf(stderr, "the scheduler ran dry after %lu of %lu cycles\n", (unsigned long)i, (unsigned long)cycles);
+            return 1;
+        }
+        bus_time_us += stats->bus_time_us;
+        max_bus_us = stats->bus_time_us > max_bus_us ? stats->bus_time_us : max_bus_us;
+        read_failures += stats->read_failures;
+#if DS18B20_ALARM_SEARCH_ENABLE
+        /* Every sensor is read when the count was a multiple before the cycle finished */
+        if ((stats->cycles - 1) % DS18B20_ALARM_FULL_READ_CYCLES == 0)
+        {
+            full_read_us += stats->bus_time_us;
+            full_reads++;
+        }
+#endif
+    }
+
+    allocations = host_allocations() - allocations;
+    writes      = zb_stats->attribute_writes - writes;
+
+    printf("sensors %u, cycles %lu\n", sensors, (unsigned long)cycles);
+    printf("bus time         %8.1f us/cycle (max %lu)\n", (double)bus_time_us / cycles, (unsigned long)max_bus_us);
+    printf("attribute writes %8.2f /cycle, %u of them measured values in the last\n", (double)writes / cycles, stats->attribute_writes);
+    printf("allocations      %8.2f /cycle\n", (double)allocations / cycles);
+    printf("read failures    %8lu\n", (unsigned long)read_failures);
+#if DS18B20_PACKED_REPORT_ENABLE
+    const packed_report_stats_t *packed_stats = packed_report_get_stats();
+    uint32_t frames                           = packed_stats->frames - packed.frames;
+    uint32_t single_reports                   = packed_stats->single_reports - packed.single_reports;
+    /* The packed frame is an octet string, one length byte ahead of the payload */
+    uint32_t packed_bytes = packed_stats->bytes - packed.bytes + frames * (BENCH_REPORT_OVERHEAD + 1);
+    printf("packed reports   %8.2f frames/cycle, %8.1f bytes/cycle\n", (double)frames / cycles, (double)packed_bytes / cycles);
+    printf(
+        "per endpoint     %8.2f frames/cycle, %8.1f bytes/cycle\n",
+        (double)single_reports / cycles,
+        (double)single_reports * BENCH_SINGLE_REPORT_SIZE / cycles);
+#endif
+#if DS18B20_ALARM_SEARCH_ENABLE
+    /* A full-read cycle reads every sensor of the same population, as a cycle without alarm search does */
+    if (full_reads > 0 && full_reads < cycles)
+    {
+        double full_read_avg_us = (double)full_read_us / full_reads;
+        printf("alarm search     %8.1f us/cycle\n", (double)(bus_time_us - full_read_us) / (cycles - full_reads));
+        printf("full read        %8.1f us/cycle, every %d cycles\n", full_read_avg_us, DS18B20_ALARM_FULL_READ_CYCLES);
+        printf("alarm vs none    %8.1f us/cycle against %.1f, %.1fx less bus time\n", (double)bus_time_us / cycles, full_read_avg_us,
+               full_read_avg_us * cycles / bus_time_us);
+    }
+    printf("TH/TL writes     %8.2f /cycle\n", (double)(sim->writes - window_writes) / cycles);
+#endif
+
+    /* Every read of a simulated sensor must succeed, the other figures are for comparing builds */
+    return read_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+#include "harness.h"
+
+#include "config.h"
+#include "esp_err.h"
+#include "event_log.h"
+#include "history.h"
+#include "host.h"
+#include "onewire_sim.h"
+#include "power.h"
+#include "thermometer.h"
+
+void harness_start(uint8_t sensors)
+{
+    onewire_sim_set_devices(GPIO_NUM_1, sensors);
+    host_partition_add("history", ESP_PARTITION_TYPE_DATA, 0x40, 64 * 1024);
+    host_partition_add("ota_1", ESP_PARTITION_TYPE_APP, 0x11, 1024 * 1024);
+
+    ESP_ERROR_CHECK(power_init());
+    ESP_ERROR_CHECK(event_log_init());
+    thermometer_init();
+#if DS18B20_HISTORY_ENABLE
+    history_init();
+#endif
+    thermometer_add_endpoints();
+    power_configure_stack();
+    thermometer_network_joined();
+}
+
+bool harness_run_cycle(void)
+{
+    uint32_t cycles = thermometer_get_stats()->cycles;
+    while (thermometer_get_stats()->cycles == cycles)
+    {
+        int64_t next_us = host_zb_next_alarm_us();
+        if (next_us < 0)
+        {
+            return false;
+        }
+        host_zb_run_until(next_us);
+    }
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* Boots the firmware modules like app_main() does, on one simulated bus of sensors, and joins the network */
+    void harness_start(uint8_t sensors);
+    /* Runs scheduler alarms until the next measurement cycle is done, false when no alarm is left */
+    bool harness_run_cycle(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,35 @@
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "host.h"
+
+/* Linked with -Wl,--wrap for malloc, calloc, realloc and free, so every heap allocation of the firmware is counted */
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static atomic_uint allocations = 0;
+
+void *__wrap_malloc(size_t size)
+{
+    atomic_fetch_add(&allocations, 1);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    atomic_fetch_add(&allocations, 1);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    atomic_fetch_add(&allocations, 1);
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) { __real_free(ptr); }
+
+uint32_t host_allocations(void) { return atomic_load(&allocations); }
@@ -0,0 +1,215 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "driver/rmt_rx.h"
+#include "driver/rmt_tx.h"
+#include "ds18b20.h"
+#include "hal/gpio_ll.h"
+#include "host.h"
+
+/*
+ * The pads keep what drives them, so a test can see the level a backend leaves on the line. Nothing is attached to
+ * a pin: an RMT capture gets back the symbols the TX channel on its pin sends, the GPIO 1-Wire library finds no
+ * device.
+ */
+
+#define HOST_GPIO_COUNT (GPIO_NUM_8 + 1)
+#define HOST_RMT_CHANNELS 8
+
+typedef struct
+{
+    bool output;
+    bool open_drain;
+    uint8_t level;               /* GPIO output register */
+    struct rmt_channel_t *signal; /* TX channel routed to the pad, NULL for the GPIO output register */
+} host_pad_t;
+
+struct gpio_dev_t
+{
+    host_pad_t pads[HOST_GPIO_COUNT];
+};
+
+struct rmt_channel_t
+{
+    bool used;
+    bool tx;
+    gpio_num_t pin;
+    uint8_t level; /* Output of a TX channel */
+    rmt_rx_done_callback_t on_recv_done;
+    void *user_data;
+    rmt_symbol_word_t *buffer; /* Pending receive */
+    size_t buffer_symbols;
+};
+
+gpio_dev_t GPIO;
+static struct rmt_channel_t rmt_channels[HOST_RMT_CHANNELS];
+static uint8_t rmt_bytes_encoder;
+static uint8_t rmt_copy_encoder;
+
+static host_pad_t *host_pad(gpio_num_t pin) { return pin >= 0 && pin < HOST_GPIO_COUNT ? &GPIO.pads[pin] : NULL; }
+
+host_gpio_drive_t host_gpio_drive(gpio_num_t pin)
+{
+    host_pad_t *pad = host_pad(pin);
+    if (pad == NULL || !pad->output)
+    {
+        return HOST_GPIO_RELEASED;
+    }
+    uint8_t level = pad->signal != NULL ? pad->signal->level : pad->level;
+    return level == 0 ? HOST_GPIO_LOW : pad->open_drain ? HOST_GPIO_RELEASED : HOST_GPIO_HIGH;
+}
+
+bool host_gpio_rmt_routed(gpio_num_t pin)
+{
+    host_pad_t *pad = host_pad(pin);
+    return pad != NULL && pad->signal != NULL;
+}
+
+/* Output modes route the pad to the GPIO output register, as gpio_output_enable() does */
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    host_pad_t *pad = host_pad(gpio_num);
+    if (pad != NULL)
+    {
+        pad->output     = mode != GPIO_MODE_DISABLE && mode != GPIO_MODE_INPUT;
+        pad->open_drain = mode == GPIO_MODE_OUTPUT_OD || mode == GPIO_MODE_INPUT_OUTPUT_OD;
+        pad->signal     = NULL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    host_pad_t *pad = host_pad(gpio_num);
+    if (pad != NULL)
+    {
+        pad->level = level != 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_pullup_en(gpio_num_t gpio_num) { return ESP_OK; }
+
+esp_err_t gpio_sleep_sel_dis(gpio_num_t gpio_num) { return ESP_OK; }
+
+void gpio_ll_od_enable(gpio_dev_t *hw, uint32_t gpio_num) { hw->pads[gpio_num].open_drain = true; }
+
+void gpio_ll_od_disable(gpio_dev_t *hw, uint32_t gpio_num) { hw->pads[gpio_num].open_drain = false; }
+
+static esp_err_t host_rmt_new_channel(gpio_num_t pin, bool tx, rmt_channel_handle_t *ret_chan)
+{
+    for (uint8_t i = 0; i < HOST_RMT_CHANNELS; i++)
+    {
+        if (!rmt_channels[i].used)
+        {
+            rmt_channels[i] = (struct rmt_channel_t){.used = true, .tx = tx, .pin = pin};
+            *ret_chan       = &rmt_channels[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t *config, rmt_channel_handle_t *ret_chan)
+{
+    esp_err_t err   = host_rmt_new_channel(config->gpio_num, true, ret_chan);
+    host_pad_t *pad = host_pad(config->gpio_num);
+    if (err == ESP_OK && pad != NULL)
+    {
+        pad->output     = true;
+        pad->open_drain = config->flags.io_od_mode;
+        pad->signal     = *ret_chan;
+    }
+    return err;
+}
+
+esp_err_t rmt_new_rx_channel(const rmt_rx_channel_config_t *config, rmt_channel_handle_t *ret_chan)
+{
+    return host_rmt_new_channel(config->gpio_num, false, ret_chan);
+}
+
+esp_err_t rmt_new_bytes_encoder(const rmt_bytes_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder)
+{
+    *ret_encoder = (rmt_encoder_handle_t)&rmt_bytes_encoder;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_copy_encoder(const rmt_copy_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder)
+{
+    *ret_encoder = (rmt_encoder_handle_t)&rmt_copy_encoder;
+    return ESP_OK;
+}
+
+esp_err_t rmt_rx_register_event_callbacks(rmt_channel_handle_t rx_channel, const rmt_rx_event_callbacks_t *cbs, void *user_data)
+{
+    rx_channel->on_recv_done = cbs->on_recv_done;
+    rx_channel->user_data    = user_data;
+    return ESP_OK;
+}
+
+esp_err_t rmt_enable(rmt_channel_handle_t channel) { return ESP_OK; }
+
+esp_err_t rmt_disable(rmt_channel_handle_t channel) { return ESP_OK; }
+
+esp_err_t rmt_receive(rmt_channel_handle_t rx_channel, void *buffer, size_t buffer_size, const rmt_receive_config_t *config)
+{
+    rx_channel->buffer         = buffer;
+    rx_channel->buffer_symbols = buffer_size / sizeof(rmt_symbol_word_t);
+    return ESP_OK;
+}
+
+esp_err_t rmt_transmit(
+    rmt_channel_handle_t tx_channel, rmt_encoder_handle_t encoder, const void *payload, size_t payload_bytes, const rmt_transmit_config_t *config)
+{
+    tx_channel->level = config->flags.eot_level;
+
+    for (uint8_t i = 0; i < HOST_RMT_CHANNELS && encoder == (rmt_encoder_handle_t)&rmt_copy_encoder; i++)
+    {
+        struct rmt_channel_t *rx = &rmt_channels[i];
+        if (rx->used && !rx->tx && rx->pin == tx_channel->pin && rx->buffer != NULL)
+        {
+            rmt_rx_done_event_data_t done = {.received_symbols = rx->buffer, .num_symbols = payload_bytes / sizeof(rmt_symbol_word_t)};
+            if (done.num_symbols > rx->buffer_symbols)
+            {
+                done.num_symbols = rx->buffer_symbols;
+            }
+            memcpy(rx->buffer, payload, done.num_symbols * sizeof(rmt_symbol_word_t));
+            rx->buffer = NULL;
+            if (rx->on_recv_done != NULL)
+            {
+                rx->on_recv_done(rx, &done, rx->user_data);
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t tx_channel, int timeout_ms) { return ESP_OK; }
+
+esp_err_t rmt_del_channel(rmt_channel_handle_t channel)
+{
+    host_pad_t *pad = host_pad(channel->pin);
+    if (pad != NULL && pad->signal == channel)
+    {
+        pad->output = false;
+        pad->signal = NULL;
+    }
+    channel->used = false;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder) { return ESP_OK; }
+
+void ds18b20_init(ds18b20_dev_t *dev, gpio_num_t pin) { dev->pin = pin; }
+
+bool ds18b20_reset(ds18b20_dev_t *dev) { return false; }
+
+void ds18b20_write(ds18b20_dev_t *dev, char bit) {}
+
+unsigned char ds18b20_read(ds18b20_dev_t *dev) { return 1; }
+
+void ds18b20_write_byte(ds18b20_dev_t *dev, uint8_t data) {}
+
+uint8_t ds18b20_read_byte(ds18b20_dev_t *dev) { return 0xFF; }
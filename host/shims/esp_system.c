@@ -0,0 +1,126 @@
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_random.h"
+#include "esp_rom_sys.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "host.h"
+
+/* Read from the formatter task as well, so every access goes through one atomic */
+static _Atomic int64_t now_us = 0;
+static uint32_t random_state  = 0x2545F491;
+
+void host_clock_advance_to(int64_t time_us)
+{
+    int64_t current = atomic_load(&now_us);
+    while (time_us > current && !atomic_compare_exchange_weak(&now_us, &current, time_us))
+    {
+    }
+}
+
+int64_t esp_timer_get_time(void) { return atomic_load(&now_us); }
+
+void esp_rom_delay_us(uint32_t us) { atomic_fetch_add(&now_us, us); }
+
+uint32_t esp_log_timestamp(void) { return (uint32_t)(atomic_load(&now_us) / 1000); }
+
+uint32_t esp_cpu_get_cycle_count(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec) * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ / 1000);
+}
+
+void host_seed(uint32_t seed) { random_state = seed ? seed : 1; }
+
+uint32_t esp_random(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static host_log_handler_t log_handler = NULL;
+
+void host_log_set_handler(host_log_handler_t handler) { log_handler = handler; }
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    if (log_handler != NULL)
+    {
+        char line[256];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        log_handler(level, tag, line);
+        return;
+    }
+
+    static int max_level = -1;
+    if (max_level < 0)
+    {
+        const char *env = getenv("HOST_LOG_LEVEL");
+        max_level       = env != NULL ? atoi(env) : ESP_LOG_WARN;
+    }
+    if ((int)level > max_level)
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:
+            return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:
+            return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:
+            return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_CRC:
+            return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_NVS_NOT_FOUND:
+            return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_NOT_ENOUGH_SPACE:
+            return "ESP_ERR_NVS_NOT_ENOUGH_SPACE";
+        default:
+            return "UNKNOWN ERROR";
+    }
+}
+
+void esp_restart(void)
+{
+    printf("esp_restart() called\n");
+    fflush(stdout);
+    exit(2);
+}
+
+esp_err_t esp_pm_configure(const void *config) { return ESP_OK; }
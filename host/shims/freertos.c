@@ -0,0 +1,250 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "host.h"
+
+/* Tasks run as threads with real time, only the firmware's Zigbee task runs on the virtual clock */
+#define HOST_TASKS 4
+#define HOST_QUEUES 4
+#define HOST_QUEUE_SIZE 64
+
+struct host_task
+{
+    pthread_t thread;
+    TaskFunction_t task_code;
+    void *parameters;
+    pthread_mutex_t lock;
+    pthread_cond_t notified;
+    pthread_cond_t idle;
+    uint32_t notifications;
+    bool notify_driven; /* Has waited in ulTaskNotifyTake, so it idles there */
+    bool waiting;
+};
+
+struct host_queue
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+    uint8_t items[HOST_QUEUE_SIZE];
+};
+
+static struct host_task tasks[HOST_TASKS];
+static uint8_t task_count = 0;
+static struct host_queue queues[HOST_QUEUES];
+static uint8_t queue_count = 0;
+static __thread struct host_task *current_task = NULL;
+
+static void *host_task_main(void *arg)
+{
+    current_task = arg;
+    current_task->task_code(current_task->parameters);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task_code, const char *name, uint32_t stack_depth, void *parameters, UBaseType_t priority, TaskHandle_t *created_task)
+{
+    if (task_count == HOST_TASKS)
+    {
+        return pdFAIL;
+    }
+
+    struct host_task *task = &tasks[task_count++];
+    task->task_code        = task_code;
+    task->parameters       = parameters;
+    task->notifications    = 0;
+    task->notify_driven    = false;
+    task->waiting          = false;
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->notified, NULL);
+    pthread_cond_init(&task->idle, NULL);
+    if (pthread_create(&task->thread, NULL, host_task_main, task) != 0)
+    {
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+
+    if (created_task != NULL)
+    {
+        *created_task = task;
+    }
+    return pdPASS;
+}
+
+static struct timespec host_deadline(TickType_t ticks)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += ticks / 1000;
+    deadline.tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    return deadline;
+}
+
+static int host_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *deadline)
+{
+    return ticks == portMAX_DELAY ? pthread_cond_wait(cond, lock) : pthread_cond_timedwait(cond, lock, deadline);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec delay = {.tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000};
+    nanosleep(&delay, NULL);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+void xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notifications++;
+    pthread_cond_signal(&task->notified);
+    pthread_mutex_unlock(&task->lock);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait)
+{
+    struct host_task *task   = current_task;
+    struct timespec deadline = host_deadline(ticks_to_wait);
+    int err                  = 0;
+
+    pthread_mutex_lock(&task->lock);
+    task->notify_driven = true;
+    task->waiting       = true;
+    pthread_cond_broadcast(&task->idle);
+    while (task->notifications == 0 && err != ETIMEDOUT)
+    {
+        err = host_wait(&task->notified, &task->lock, ticks_to_wait, &deadline);
+    }
+    task->waiting  = false;
+    uint32_t value = task->notifications;
+    if (value > 0)
+    {
+        task->notifications = clear_count_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+void host_tasks_wait_idle(void)
+{
+    for (uint8_t i = 0; i < task_count; i++)
+    {
+        struct host_task *task = &tasks[i];
+        if (task == current_task)
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&task->lock);
+        while (task->notify_driven && (!task->waiting || task->notifications > 0))
+        {
+            pthread_cond_wait(&task->idle, &task->lock);
+        }
+        pthread_mutex_unlock(&task->lock);
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    if (queue_count == HOST_QUEUES || length * item_size > HOST_QUEUE_SIZE)
+    {
+        return NULL;
+    }
+
+    struct host_queue *queue = &queues[queue_count++];
+    queue->length            = length;
+    queue->item_size         = item_size;
+    queue->count             = 0;
+    queue->head              = 0;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    return queue;
+}
+
+static void host_queue_push(struct host_queue *queue, const void *item)
+{
+    memcpy(&queue->items[(queue->head + queue->count) % queue->length * queue->item_size], item, queue->item_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->changed);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    struct timespec deadline = host_deadline(ticks_to_wait);
+    int err                  = 0;
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length && err != ETIMEDOUT)
+    {
+        err = host_wait(&queue->changed, &queue->lock, ticks_to_wait, &deadline);
+    }
+    BaseType_t sent = queue->count < queue->length;
+    if (sent)
+    {
+        host_queue_push(queue, item);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return sent ? pdPASS : pdFAIL;
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item)
+{
+    pthread_mutex_lock(&queue->lock);
+    queue->count = 0;
+    host_queue_push(queue, item);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+/* The shims call interrupt callbacks on the thread that caused them, a full queue fails as it does in an ISR */
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higher_priority_task_woken)
+{
+    if (higher_priority_task_woken != NULL)
+    {
+        *higher_priority_task_woken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticks_to_wait)
+{
+    struct timespec deadline = host_deadline(ticks_to_wait);
+    int err                  = 0;
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && err != ETIMEDOUT)
+    {
+        err = host_wait(&queue->changed, &queue->lock, ticks_to_wait, &deadline);
+    }
+    BaseType_t received = queue->count > 0;
+    if (received)
+    {
+        memcpy(buffer, &queue->items[queue->head * queue->item_size], queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return received ? pdTRUE : pdFALSE;
+}
+
+void vQueueDelete(QueueHandle_t queue) {}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef enum
+    {
+        GPIO_NUM_NC = -1,
+        GPIO_NUM_0  = 0,
+        GPIO_NUM_1  = 1,
+        GPIO_NUM_2  = 2,
+        GPIO_NUM_3  = 3,
+        GPIO_NUM_4  = 4,
+        GPIO_NUM_5  = 5,
+        GPIO_NUM_6  = 6,
+        GPIO_NUM_7  = 7,
+        GPIO_NUM_8  = 8,
+    } gpio_num_t;
+
+    typedef enum
+    {
+        GPIO_MODE_DISABLE,
+        GPIO_MODE_INPUT,
+        GPIO_MODE_OUTPUT,
+        GPIO_MODE_OUTPUT_OD,
+        GPIO_MODE_INPUT_OUTPUT_OD,
+        GPIO_MODE_INPUT_OUTPUT,
+    } gpio_mode_t;
+
+    esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode);
+    esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+    esp_err_t gpio_pullup_en(gpio_num_t gpio_num);
+    esp_err_t gpio_sleep_sel_dis(gpio_num_t gpio_num);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/rmt_tx.h" /* Channel handles and symbols */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        gpio_num_t gpio_num;
+        int clk_src;
+        uint32_t resolution_hz;
+        size_t mem_block_symbols;
+        int intr_priority;
+        struct
+        {
+            uint32_t invert_in : 1;
+            uint32_t with_dma : 1;
+            uint32_t io_loop_back : 1;
+        } flags;
+    } rmt_rx_channel_config_t;
+
+    typedef struct
+    {
+        uint32_t signal_range_min_ns;
+        uint32_t signal_range_max_ns;
+    } rmt_receive_config_t;
+
+    typedef struct
+    {
+        rmt_symbol_word_t *received_symbols;
+        size_t num_symbols;
+    } rmt_rx_done_event_data_t;
+
+    typedef bool (*rmt_rx_done_callback_t)(rmt_channel_handle_t rx_chan, const rmt_rx_done_event_data_t *edata, void *user_ctx);
+
+    typedef struct
+    {
+        rmt_rx_done_callback_t on_recv_done;
+    } rmt_rx_event_callbacks_t;
+
+    /* Nothing is attached to a host pin, a receive captures what a TX channel on the same pin transmits next */
+    esp_err_t rmt_new_rx_channel(const rmt_rx_channel_config_t *config, rmt_channel_handle_t *ret_chan);
+    esp_err_t rmt_receive(rmt_channel_handle_t rx_channel, void *buffer, size_t buffer_size, const rmt_receive_config_t *config);
+    esp_err_t rmt_rx_register_event_callbacks(rmt_channel_handle_t rx_channel, const rmt_rx_event_callbacks_t *cbs, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
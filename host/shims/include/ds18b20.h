@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* Software-timed DS18B20 library used by onewire_gpio_backend. On the host nothing answers its resets,
+       so the thermometer falls back to it only to find an empty bus. */
+    typedef uint8_t DeviceAddress[8];
+
+    typedef struct
+    {
+        uint8_t LastDiscrepancy;
+        bool LastDeviceFlag;
+        uint8_t LastFamilyDiscrepancy;
+        uint8_t ROM_NO[8];
+    } ds18b20_search_t;
+
+    typedef struct
+    {
+        gpio_num_t pin;
+        bool parasite;
+        uint8_t bitResolution;
+        ds18b20_search_t search;
+    } ds18b20_dev_t;
+
+    void ds18b20_init(ds18b20_dev_t *dev, gpio_num_t pin);
+    bool ds18b20_reset(ds18b20_dev_t *dev);
+    void ds18b20_write(ds18b20_dev_t *dev, char bit);
+    unsigned char ds18b20_read(ds18b20_dev_t *dev);
+    void ds18b20_write_byte(ds18b20_dev_t *dev, uint8_t data);
+    uint8_t ds18b20_read_byte(ds18b20_dev_t *dev);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Host CPU time scaled to the 160 MHz of the ESP32-C6 */
+uint32_t esp_cpu_get_cycle_count(void);
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Deterministic on the host, reseeded with host_seed() */
+uint32_t esp_random(void);
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Virtual microseconds since boot, only bus delays and the Zigbee scheduler move the clock on the host */
+int64_t esp_timer_get_time(void);
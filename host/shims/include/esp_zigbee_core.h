@@ -0,0 +1,394 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ESP_ZB_AF_HA_PROFILE_ID 0x0104
+#define ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID 0x0302
+#define ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE 0x0019
+#define ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT 0x0402
+#define ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS 0x0b05
+#define ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID 0x0000
+#define ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC 0xffff
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID 0xfff1
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID 0xfff2
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID 0xfff3
+#define ESP_ZB_ZCL_OTA_UPGRADE_QUERY_TIMER_COUNT_DEF 1440
+#define ESP_ZB_DEVICE_TYPE_ED 2
+#define ESP_ZB_ED_AGING_TIMEOUT_64MIN 7
+#define ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK 0x07FFF800U
+
+    typedef enum
+    {
+        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE = 0x01,
+        ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE = 0x02,
+    } esp_zb_zcl_cluster_role_t;
+
+    typedef enum
+    {
+        ESP_ZB_ZCL_STATUS_SUCCESS       = 0x00,
+        ESP_ZB_ZCL_STATUS_FAIL          = 0x01,
+        ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB  = 0x86,
+        ESP_ZB_ZCL_STATUS_INVALID_VALUE = 0x87,
+    } esp_zb_zcl_status_t;
+
+    typedef enum
+    {
+        ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV = 0x00,
+        ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI = 0x01,
+    } esp_zb_zcl_cmd_direction_t;
+
+    typedef enum
+    {
+        ESP_ZB_ZCL_ATTR_TYPE_BOOL         = 0x10,
+        ESP_ZB_ZCL_ATTR_TYPE_U8           = 0x20,
+        ESP_ZB_ZCL_ATTR_TYPE_U16          = 0x21,
+        ESP_ZB_ZCL_ATTR_TYPE_U32          = 0x23,
+        ESP_ZB_ZCL_ATTR_TYPE_S16          = 0x29,
+        ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM    = 0x30,
+        ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING = 0x41,
+    } esp_zb_zcl_attr_type_t;
+
+    typedef enum
+    {
+        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY  = 0x01,
+        ESP_ZB_ZCL_ATTR_ACCESS_WRITE_ONLY = 0x02,
+        ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE = 0x03,
+        ESP_ZB_ZCL_ATTR_ACCESS_REPORTING  = 0x04,
+    } esp_zb_zcl_attr_access_t;
+
+    typedef enum
+    {
+        ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT = 0x00,
+        ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT           = 0x02,
+    } esp_zb_aps_address_mode_t;
+
+    typedef enum
+    {
+        ESP_ZB_ZCL_ADDR_TYPE_SHORT       = 0,
+        ESP_ZB_ZCL_ADDR_TYPE_IEEE_GPD    = 1,
+        ESP_ZB_ZCL_ADDR_TYPE_SRC_ID_GPD  = 2,
+        ESP_ZB_ZCL_ADDR_TYPE_IEEE        = 3,
+    } esp_zb_zcl_address_type_t;
+
+    typedef enum
+    {
+        ESP_ZB_ZDO_SIGNAL_DEFAULT_START                          = 0x00,
+        ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP                           = 0x01,
+        ESP_ZB_ZDO_SIGNAL_DEVICE_ANNCE                           = 0x02,
+        ESP_ZB_ZDO_SIGNAL_LEAVE                                  = 0x03,
+        ESP_ZB_ZDO_SIGNAL_ERROR                                  = 0x04,
+        ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START                     = 0x05,
+        ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT                          = 0x06,
+        ESP_ZB_BDB_SIGNAL_TOUCHLINK_NWK_STARTED                  = 0x07,
+        ESP_ZB_BDB_SIGNAL_TOUCHLINK_NWK_JOINED_ROUTER            = 0x08,
+        ESP_ZB_BDB_SIGNAL_TOUCHLINK                              = 0x09,
+        ESP_ZB_BDB_SIGNAL_STEERING                               = 0x0a,
+        ESP_ZB_BDB_SIGNAL_FORMATION                              = 0x0b,
+        ESP_ZB_BDB_SIGNAL_FINDING_AND_BINDING_TARGET_FINISHED    = 0x0c,
+        ESP_ZB_BDB_SIGNAL_FINDING_AND_BINDING_INITIATOR_FINISHED = 0x0d,
+        ESP_ZB_BDB_SIGNAL_TOUCHLINK_TARGET                       = 0x0e,
+        ESP_ZB_BDB_SIGNAL_TOUCHLINK_NWK                          = 0x0f,
+        ESP_ZB_BDB_SIGNAL_TOUCHLINK_TARGET_FINISHED              = 0x10,
+        ESP_ZB_NWK_SIGNAL_DEVICE_ASSOCIATED                      = 0x12,
+        ESP_ZB_ZDO_SIGNAL_LEAVE_INDICATION                       = 0x13,
+        ESP_ZB_ZGP_SIGNAL_COMMISSIONING                          = 0x15,
+        ESP_ZB_COMMON_SIGNAL_CAN_SLEEP                           = 0x16,
+        ESP_ZB_ZDO_SIGNAL_PRODUCTION_CONFIG_READY                = 0x17,
+        ESP_ZB_NWK_SIGNAL_NO_ACTIVE_LINKS_LEFT                   = 0x18,
+        ESP_ZB_ZDO_SIGNAL_DEVICE_AUTHORIZED                      = 0x2f,
+        ESP_ZB_ZDO_SIGNAL_DEVICE_UPDATE                          = 0x30,
+        ESP_ZB_NWK_SIGNAL_PANID_CONFLICT_DETECTED                = 0x31,
+        ESP_ZB_NLME_STATUS_INDICATION                            = 0x32,
+        ESP_ZB_BDB_SIGNAL_TC_REJOIN_DONE                         = 0x35,
+        ESP_ZB_NWK_SIGNAL_PERMIT_JOIN_STATUS                     = 0x36,
+        ESP_ZB_BDB_SIGNAL_STEERING_CANCELLED                     = 0x37,
+        ESP_ZB_BDB_SIGNAL_FORMATION_CANCELLED                    = 0x38,
+        ESP_ZB_ZGP_SIGNAL_MODE_CHANGE                            = 0x3b,
+        ESP_ZB_ZDO_DEVICE_UNAVAILABLE                            = 0x3c,
+        ESP_ZB_ZGP_SIGNAL_APPROVE_COMMISSIONING                  = 0x3d,
+    } esp_zb_app_signal_type_t;
+
+    typedef enum
+    {
+        ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID          = 0x0000,
+        ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID       = 0x0004,
+        ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID        = 0x1007,
+        ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID  = 0x1012,
+    } esp_zb_core_action_callback_id_t;
+
+    /* Clusters and lists only need to exist, the host keeps attribute values in its own table */
+    typedef struct esp_zb_attribute_list_s esp_zb_attribute_list_t;
+    typedef struct esp_zb_cluster_list_s esp_zb_cluster_list_t;
+    typedef struct esp_zb_ep_list_s esp_zb_ep_list_t;
+
+    typedef struct
+    {
+        uint8_t endpoint;
+        uint16_t app_profile_id;
+        uint16_t app_device_id;
+        uint32_t app_device_version;
+    } esp_zb_endpoint_config_t;
+
+    typedef union
+    {
+        uint8_t u8;
+        int8_t s8;
+        uint16_t u16;
+        int16_t s16;
+        uint32_t u32;
+        int32_t s32;
+        uint8_t data_buf[4];
+    } esp_zb_zcl_attr_var_t;
+
+    typedef struct
+    {
+        uint8_t direction;
+        uint8_t ep;
+        uint16_t cluster_id;
+        uint8_t cluster_role;
+        uint16_t attr_id;
+        uint8_t flags;
+        uint64_t run_time;
+        union
+        {
+            struct
+            {
+                uint16_t min_interval;
+                uint16_t max_interval;
+                esp_zb_zcl_attr_var_t delta;
+                esp_zb_zcl_attr_var_t reported_value;
+                uint16_t def_min_interval;
+                uint16_t def_max_interval;
+            } send_info;
+            struct
+            {
+                uint16_t timeout;
+            } recv_info;
+        } u;
+        struct
+        {
+            uint16_t short_addr;
+            uint8_t endpoint;
+            uint16_t profile_id;
+        } dst;
+        uint16_t manuf_code;
+    } esp_zb_zcl_reporting_info_t;
+
+    typedef struct
+    {
+        uint8_t endpoint_id;
+        uint16_t cluster_id;
+        uint8_t cluster_role;
+        uint16_t manuf_code;
+        uint16_t attr_id;
+    } esp_zb_zcl_attr_location_info_t;
+
+    typedef struct
+    {
+        union
+        {
+            uint16_t addr_short;
+            uint8_t addr_long[8];
+        } dst_addr_u;
+        uint8_t dst_endpoint;
+        uint8_t src_endpoint;
+    } esp_zb_zcl_basic_cmd_t;
+
+    typedef struct
+    {
+        esp_zb_zcl_basic_cmd_t zcl_basic_cmd;
+        esp_zb_aps_address_mode_t address_mode;
+        uint16_t clusterID;
+        uint16_t attributeID;
+        uint8_t direction;
+        uint8_t manuf_specific;
+        uint16_t manuf_code;
+    } esp_zb_zcl_report_attr_cmd_t;
+
+    typedef struct
+    {
+        esp_zb_zcl_attr_type_t type;
+        uint16_t size;
+        void *value;
+    } esp_zb_zcl_attribute_data_t;
+
+    typedef struct
+    {
+        uint16_t id;
+        esp_zb_zcl_attribute_data_t data;
+    } esp_zb_zcl_attribute_t;
+
+    typedef struct
+    {
+        esp_zb_zcl_basic_cmd_t zcl_basic_cmd;
+        esp_zb_aps_address_mode_t address_mode;
+        uint16_t profile_id;
+        uint16_t cluster_id;
+        uint16_t custom_cmd_id;
+        uint8_t direction;
+        uint8_t dis_defalut_resp;
+        uint8_t manuf_specific;
+        uint16_t manuf_code;
+        esp_zb_zcl_attribute_data_t data;
+    } esp_zb_zcl_custom_cluster_cmd_req_t;
+
+    typedef struct
+    {
+        esp_zb_zcl_address_type_t addr_type;
+        union
+        {
+            uint16_t short_addr;
+            uint32_t src_id;
+            uint8_t ieee_addr[8];
+        } u;
+    } esp_zb_zcl_addr_t;
+
+    typedef struct
+    {
+        esp_zb_zcl_status_t status;
+        esp_zb_zcl_addr_t src_address;
+        uint8_t src_endpoint;
+        uint8_t dst_endpoint;
+        uint16_t cluster;
+        uint16_t profile;
+        struct
+        {
+            uint8_t tsn;
+            uint8_t direction;
+            uint8_t is_common;
+            uint8_t id;
+        } command;
+        struct
+        {
+            uint16_t src_short;
+            int8_t rssi;
+            uint8_t lqi;
+        } header;
+    } esp_zb_zcl_cmd_info_t;
+
+    typedef struct
+    {
+        esp_zb_zcl_status_t status;
+        uint8_t dst_endpoint;
+        uint16_t cluster;
+    } esp_zb_device_cb_common_info_t;
+
+    typedef struct
+    {
+        esp_zb_zcl_cmd_info_t info;
+        esp_zb_zcl_attribute_t attribute;
+    } esp_zb_zcl_set_attr_value_message_t;
+
+    typedef struct
+    {
+        esp_zb_zcl_cmd_info_t info;
+        esp_zb_zcl_attribute_data_t data;
+    } esp_zb_zcl_custom_cluster_command_message_t;
+
+    typedef struct
+    {
+        esp_zb_zcl_cmd_info_t info;
+        uint8_t resp_to_cmd;
+        esp_zb_zcl_status_t status_code;
+    } esp_zb_zcl_cmd_default_resp_message_t;
+
+    typedef struct
+    {
+        uint32_t ota_upgrade_file_version;
+        uint16_t ota_upgrade_manufacturer;
+        uint16_t ota_upgrade_image_type;
+        uint32_t ota_min_block_reque;
+        uint32_t ota_upgrade_file_offset;
+        uint32_t ota_upgrade_downloaded_file_ver;
+        uint16_t ota_upgrade_server_id;
+        uint8_t ota_image_upgrade_status;
+    } esp_zb_ota_cluster_cfg_t;
+
+    typedef struct
+    {
+        uint16_t timer_query;
+        uint16_t hw_version;
+        uint8_t max_data_size;
+    } esp_zb_zcl_ota_upgrade_client_variable_t;
+
+    typedef enum
+    {
+        ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START   = 0x0000,
+        ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY   = 0x0001,
+        ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE = 0x0002,
+        ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH  = 0x0003,
+        ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT   = 0x0004,
+        ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK   = 0x0005,
+        ESP_ZB_ZCL_OTA_UPGRADE_STATUS_OK      = 0x0006,
+        ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR   = 0x0007,
+    } esp_zb_zcl_ota_upgrade_status_t;
+
+    typedef struct
+    {
+        uint16_t manufacturer_code;
+        uint16_t image_type;
+        uint32_t file_version;
+        uint32_t image_size;
+    } esp_zb_zcl_ota_upgrade_ota_header_t;
+
+    typedef struct
+    {
+        esp_zb_device_cb_common_info_t info;
+        esp_zb_zcl_ota_upgrade_status_t upgrade_status;
+        esp_zb_zcl_ota_upgrade_ota_header_t ota_header;
+        uint16_t payload_size;
+        uint8_t *payload;
+    } esp_zb_zcl_ota_upgrade_value_message_t;
+
+    typedef void (*esp_zb_callback_t)(uint8_t param);
+    typedef void (*esp_zb_user_callback_t)(void *param);
+    typedef uint32_t esp_zb_user_cb_handle_t;
+
+    /* Scheduler, run by host_zb_run_until() on the virtual clock */
+    void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time);
+    void esp_zb_scheduler_alarm_cancel(esp_zb_callback_t cb, uint8_t param);
+    esp_zb_user_cb_handle_t esp_zb_scheduler_user_alarm(esp_zb_user_callback_t cb, void *param, uint32_t time);
+    esp_err_t esp_zb_scheduler_user_alarm_cancel(esp_zb_user_cb_handle_t handle);
+
+    /* Data model */
+    esp_zb_attribute_list_t *esp_zb_zcl_attr_list_create(uint16_t cluster_id);
+    esp_err_t esp_zb_custom_cluster_add_custom_attr(
+        esp_zb_attribute_list_t *attr_list, uint16_t attr_id, uint8_t attr_type, uint8_t attr_access, void *value_p);
+    esp_err_t esp_zb_cluster_add_manufacturer_attr(
+        esp_zb_attribute_list_t *attr_list, uint16_t cluster_id, uint16_t attr_id, uint16_t manuf_code, uint8_t attr_type, uint8_t attr_access, void *value_p);
+    esp_err_t esp_zb_cluster_list_add_custom_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+    esp_err_t esp_zb_cluster_list_add_diagnostics_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+    esp_err_t esp_zb_cluster_list_add_ota_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+    esp_zb_attribute_list_t *esp_zb_ota_cluster_create(esp_zb_ota_cluster_cfg_t *ota_cfg);
+    esp_err_t esp_zb_ota_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+    esp_zb_ep_list_t *esp_zb_ep_list_create(void);
+    esp_err_t esp_zb_ep_list_add_ep(esp_zb_ep_list_t *ep_list, esp_zb_cluster_list_t *cluster_list, esp_zb_endpoint_config_t endpoint_config);
+    esp_err_t esp_zb_device_register(esp_zb_ep_list_t *ep_list);
+
+    /* Attributes, reporting and commands */
+    esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id, void *value_p, bool check);
+    esp_zb_zcl_status_t esp_zb_zcl_set_manufacturer_attribute_val(
+        uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t manuf_code, uint16_t attr_id, void *value_p, bool check);
+    esp_zb_zcl_reporting_info_t *esp_zb_zcl_find_reporting_info(esp_zb_zcl_attr_location_info_t attr_info);
+    esp_err_t esp_zb_zcl_update_reporting_info(esp_zb_zcl_reporting_info_t *report_info);
+    uint8_t esp_zb_zcl_report_attr_cmd_req(esp_zb_zcl_report_attr_cmd_t *cmd_req);
+    uint8_t esp_zb_zcl_custom_cluster_cmd_req(esp_zb_zcl_custom_cluster_cmd_req_t *cmd_req);
+
+    /* Power */
+    void esp_zb_sleep_enable(bool enable);
+    void esp_zb_set_rx_on_when_idle(bool rx_on);
+    void esp_zb_sleep_now(void);
+    void esp_zb_zdo_pim_set_long_poll_interval(uint32_t ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct host_queue *QueueHandle_t;
+
+    QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+    BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait);
+    BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item);
+    BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higher_priority_task_woken);
+    BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticks_to_wait);
+    void vQueueDelete(QueueHandle_t queue);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct host_task *TaskHandle_t;
+    typedef void (*TaskFunction_t)(void *);
+
+    BaseType_t xTaskCreate(
+        TaskFunction_t task_code, const char *name, uint32_t stack_depth, void *parameters, UBaseType_t priority, TaskHandle_t *created_task);
+    void vTaskDelay(TickType_t ticks);
+    TickType_t xTaskGetTickCount(void);
+    void xTaskNotifyGive(TaskHandle_t task);
+    uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "esp_zigbee_core.h"
+
+typedef struct
+{
+    int16_t measured_value;
+    int16_t min_value;
+    int16_t max_value;
+} esp_zb_temperature_sensor_cfg_t;
+
+#define ESP_ZB_DEFAULT_TEMPERATURE_SENSOR_CONFIG() \
+    {                                              \
+        .measured_value = (int16_t)0x8000,         \
+        .min_value      = (int16_t)0x954d,         \
+        .max_value      = 0x7ffe,                  \
+    }
+
+esp_zb_cluster_list_t *esp_zb_temperature_sensor_clusters_create(esp_zb_temperature_sensor_cfg_t *temperature_sensor);
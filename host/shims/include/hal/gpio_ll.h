@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* The pads of host/shims/drivers.c stand in for the GPIO registers */
+    typedef struct gpio_dev_t gpio_dev_t;
+    extern gpio_dev_t GPIO;
+
+    void gpio_ll_od_enable(gpio_dev_t *hw, uint32_t gpio_num);
+    void gpio_ll_od_disable(gpio_dev_t *hw, uint32_t gpio_num);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /*
+     * Controls of the host shims for tests and benchmarks. Time is virtual: it only moves when the
+     * firmware waits on the bus through esp_rom_delay_us or when host_zb_run_until() jumps to the
+     * next scheduler alarm, so runs are repeatable and a cycle takes no longer than its CPU work.
+     */
+
+    typedef struct
+    {
+        uint32_t attribute_writes; /* esp_zb_zcl_set_attribute_val and the manufacturer-specific variant */
+        uint32_t reports;          /* Report Attributes commands sent */
+        uint32_t commands;         /* Custom cluster commands sent */
+        uint32_t command_bytes;    /* Their payload */
+    } host_zb_stats_t;
+
+    typedef struct
+    {
+        uint32_t read_bytes;
+        uint32_t written_bytes;
+        uint32_t erased_bytes;
+        uint32_t erases;
+    } host_flash_stats_t;
+
+    typedef enum
+    {
+        HOST_GPIO_LOW,      /* Pulled low */
+        HOST_GPIO_RELEASED, /* Left to the pullup resistor, or to a device pulling low */
+        HOST_GPIO_HIGH,     /* Driven high */
+    } host_gpio_drive_t;
+
+    typedef void (*host_zb_command_handler_t)(const esp_zb_zcl_custom_cluster_cmd_req_t *cmd_req);
+    typedef void (*host_log_handler_t)(esp_log_level_t level, const char *tag, const char *line);
+
+    void host_seed(uint32_t seed);
+    /* Moves the virtual clock forward, never back */
+    void host_clock_advance_to(int64_t time_us);
+
+    /* Runs the scheduler alarms due until time_us, returns the number of alarms run */
+    uint32_t host_zb_run_until(int64_t time_us);
+    /* Due time of the earliest pending alarm, -1 when none is pending */
+    int64_t host_zb_next_alarm_us(void);
+    host_zb_stats_t *host_zb_get_stats(void);
+    /* Last value written to an attribute, NULL when it was never written */
+    const void *host_zb_attribute(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id);
+    /* Called for every custom cluster command the firmware sends */
+    void host_zb_set_command_handler(host_zb_command_handler_t handler);
+
+    /* Gets every log line, whatever HOST_LOG_LEVEL says, instead of standard output */
+    void host_log_set_handler(host_log_handler_t handler);
+
+    /* Waits until the tasks driven by notifications wait for the next one, as they would run while the Zigbee
+       task idles until its next alarm */
+    void host_tasks_wait_idle(void);
+
+    /* What the pad does with the line, from the GPIO output register or the RMT TX channel routed to it */
+    host_gpio_drive_t host_gpio_drive(gpio_num_t pin);
+    /* True while an RMT TX channel drives the pad */
+    bool host_gpio_rmt_routed(gpio_num_t pin);
+
+    /* Allocations through malloc, calloc and realloc since start */
+    uint32_t host_allocations(void);
+
+    /* Erased flash of size bytes kept in an unlinked temporary file, found by its label */
+    const esp_partition_t *host_partition_add(const char *label, esp_partition_type_t type, uint8_t subtype, uint32_t size);
+    host_flash_stats_t *host_partition_get_stats(const esp_partition_t *partition);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef uint32_t nvs_handle_t;
+
+    typedef enum
+    {
+        NVS_READONLY,
+        NVS_READWRITE,
+    } nvs_open_mode_t;
+
+    typedef struct
+    {
+        size_t used_entries;
+        size_t free_entries;
+        size_t available_entries;
+        size_t total_entries;
+        size_t namespace_count;
+    } nvs_stats_t;
+
+    /* Kept in memory, entries are counted like the 32-byte entries of the NVS partition */
+    esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle);
+    esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length);
+    esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
+    esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key);
+    esp_err_t nvs_commit(nvs_handle_t handle);
+    void nvs_close(nvs_handle_t handle);
+    esp_err_t nvs_get_stats(const char *part_name, nvs_stats_t *nvs_stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,161 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "nvs.h"
+#include "nvs_flash.h"
+
+/* The 24 KiB nvs partition: 6 pages of 126 entries, one page is kept empty for garbage collection */
+#define HOST_NVS_PAGES 6
+#define HOST_NVS_PAGE_ENTRIES 126
+#define HOST_NVS_ENTRY_SIZE 32
+#define HOST_NVS_NAMESPACES 8
+#define HOST_NVS_KEYS 64
+#define HOST_NVS_BLOB_SIZE 1024
+#define HOST_NVS_KEY_SIZE 16
+
+typedef struct
+{
+    bool used;
+    uint8_t ns;
+    char key[HOST_NVS_KEY_SIZE];
+    size_t length;
+    uint8_t value[HOST_NVS_BLOB_SIZE];
+} host_nvs_entry_t;
+
+static char namespaces[HOST_NVS_NAMESPACES][HOST_NVS_KEY_SIZE];
+static uint8_t namespace_count = 0;
+static host_nvs_entry_t entries[HOST_NVS_KEYS];
+
+esp_err_t nvs_flash_init(void) { return ESP_OK; }
+
+esp_err_t nvs_flash_erase(void)
+{
+    namespace_count = 0;
+    memset(entries, 0, sizeof(entries));
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    for (uint8_t i = 0; i < namespace_count; i++)
+    {
+        if (strcmp(namespaces[i], namespace_name) == 0)
+        {
+            *out_handle = i + 1;
+            return ESP_OK;
+        }
+    }
+    if (open_mode == NVS_READONLY)
+    {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (namespace_count == HOST_NVS_NAMESPACES || strlen(namespace_name) >= HOST_NVS_KEY_SIZE)
+    {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+
+    strcpy(namespaces[namespace_count], namespace_name);
+    *out_handle = ++namespace_count;
+    return ESP_OK;
+}
+
+static host_nvs_entry_t *host_nvs_find(nvs_handle_t handle, const char *key)
+{
+    for (uint8_t i = 0; i < HOST_NVS_KEYS; i++)
+    {
+        if (entries[i].used && entries[i].ns == handle && strcmp(entries[i].key, key) == 0)
+        {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    host_nvs_entry_t *entry = host_nvs_find(handle, key);
+    if (entry == NULL)
+    {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out_value == NULL)
+    {
+        *length = entry->length;
+        return ESP_OK;
+    }
+    if (*length < entry->length)
+    {
+        *length = entry->length;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memcpy(out_value, entry->value, entry->length);
+    *length = entry->length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    if (length > HOST_NVS_BLOB_SIZE || strlen(key) >= HOST_NVS_KEY_SIZE)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    host_nvs_entry_t *entry = host_nvs_find(handle, key);
+    for (uint8_t i = 0; entry == NULL && i < HOST_NVS_KEYS; i++)
+    {
+        if (!entries[i].used)
+        {
+            entry       = &entries[i];
+            entry->used = true;
+            entry->ns   = handle;
+            strcpy(entry->key, key);
+        }
+    }
+    if (entry == NULL)
+    {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+
+    memcpy(entry->value, value, length);
+    entry->length = length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    host_nvs_entry_t *entry = host_nvs_find(handle, key);
+    if (entry == NULL)
+    {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    entry->used = false;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) { return ESP_OK; }
+
+void nvs_close(nvs_handle_t handle) {}
+
+/* A blob takes an index entry, a data header and its data in 32-byte entries, a namespace takes one entry */
+esp_err_t nvs_get_stats(const char *part_name, nvs_stats_t *nvs_stats)
+{
+    size_t used = namespace_count;
+
+    for (uint8_t i = 0; i < HOST_NVS_KEYS; i++)
+    {
+        if (entries[i].used)
+        {
+            used += 2 + (entries[i].length + HOST_NVS_ENTRY_SIZE - 1) / HOST_NVS_ENTRY_SIZE;
+        }
+    }
+
+    *nvs_stats = (nvs_stats_t){
+        .used_entries      = used,
+        .free_entries      = HOST_NVS_PAGES * HOST_NVS_PAGE_ENTRIES - used,
+        .available_entries = (HOST_NVS_PAGES - 1) * HOST_NVS_PAGE_ENTRIES - used,
+        .total_entries     = HOST_NVS_PAGES * HOST_NVS_PAGE_ENTRIES,
+        .namespace_count   = namespace_count,
+    };
+    return ESP_OK;
+}
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "host.h"
+
+/* Flash kept in temporary files: erase sets bytes to 0xFF and a write can only clear bits, like NOR flash */
+#define HOST_PARTITIONS 4
+#define HOST_FLASH_SECTOR_SIZE 4096
+
+typedef struct
+{
+    esp_partition_t partition;
+    FILE *file;
+    host_flash_stats_t stats;
+} host_partition_t;
+
+static host_partition_t partitions[HOST_PARTITIONS];
+static uint8_t partition_count = 0;
+static size_t ota_offset       = 0;
+static bool ota_open           = false;
+
+static host_partition_t *host_partition(const esp_partition_t *partition) { return (host_partition_t *)partition; }
+
+const esp_partition_t *host_partition_add(const char *label, esp_partition_type_t type, uint8_t subtype, uint32_t size)
+{
+    if (partition_count == HOST_PARTITIONS)
+    {
+        return NULL;
+    }
+
+    host_partition_t *added = &partitions[partition_count];
+    added->partition        = (esp_partition_t){
+        .type       = type,
+        .subtype    = subtype,
+        .address    = 0x100000 * (partition_count + 1),
+        .size       = size,
+        .erase_size = HOST_FLASH_SECTOR_SIZE,
+    };
+    added->file = tmpfile();
+    if (added->file == NULL)
+    {
+        return NULL;
+    }
+    strncpy(added->partition.label, label, sizeof(added->partition.label) - 1);
+
+    uint8_t erased[HOST_FLASH_SECTOR_SIZE];
+    memset(erased, 0xFF, sizeof(erased));
+    for (uint32_t offset = 0; offset < size; offset += sizeof(erased))
+    {
+        fwrite(erased, 1, sizeof(erased), added->file);
+    }
+    partition_count++;
+    return &added->partition;
+}
+
+host_flash_stats_t *host_partition_get_stats(const esp_partition_t *partition) { return &host_partition(partition)->stats; }
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label)
+{
+    for (uint8_t i = 0; i < partition_count; i++)
+    {
+        const esp_partition_t *partition = &partitions[i].partition;
+        if (partition->type == type && (subtype == ESP_PARTITION_SUBTYPE_ANY || partition->subtype == subtype) &&
+            (label == NULL || strcmp(partition->label, label) == 0))
+        {
+            return partition;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    host_partition_t *flash = host_partition(partition);
+    if (src_offset + size > partition->size)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    fseek(flash->file, src_offset, SEEK_SET);
+    if (fread(dst, 1, size, flash->file) != size)
+    {
+        return ESP_FAIL;
+    }
+    flash->stats.read_bytes += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    host_partition_t *flash = host_partition(partition);
+    const uint8_t *data     = src;
+    if (dst_offset + size > partition->size)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        uint8_t current;
+        fseek(flash->file, dst_offset + i, SEEK_SET);
+        if (fread(&current, 1, 1, flash->file) != 1)
+        {
+            return ESP_FAIL;
+        }
+        current &= data[i];
+        fseek(flash->file, dst_offset + i, SEEK_SET);
+        fwrite(&current, 1, 1, flash->file);
+    }
+    flash->stats.written_bytes += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    host_partition_t *flash = host_partition(partition);
+    if (offset % HOST_FLASH_SECTOR_SIZE || size % HOST_FLASH_SECTOR_SIZE || offset + size > partition->size)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t erased[HOST_FLASH_SECTOR_SIZE];
+    memset(erased, 0xFF, sizeof(erased));
+    fseek(flash->file, offset, SEEK_SET);
+    for (size_t done = 0; done < size; done += sizeof(erased))
+    {
+        fwrite(erased, 1, sizeof(erased), flash->file);
+    }
+    flash->stats.erased_bytes += size;
+    flash->stats.erases += size / HOST_FLASH_SECTOR_SIZE;
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    return esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, "ota_1");
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void) { return NULL; }
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
+{
+    if (partition == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (image_size != OTA_WITH_SEQUENTIAL_WRITES)
+    {
+        size_t erase_size = partition->size;
+        if (image_size != OTA_SIZE_UNKNOWN)
+        {
+            erase_size = (image_size + HOST_FLASH_SECTOR_SIZE - 1) / HOST_FLASH_SECTOR_SIZE * HOST_FLASH_SECTOR_SIZE;
+        }
+        esp_partition_erase_range(partition, 0, erase_size);
+    }
+    ota_offset  = 0;
+    ota_open    = true;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+/* Sequential writes erase each sector as the image reaches it */
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (!ota_open || partition == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    for (size_t sector = (ota_offset + HOST_FLASH_SECTOR_SIZE - 1) / HOST_FLASH_SECTOR_SIZE * HOST_FLASH_SECTOR_SIZE; sector < ota_offset + size;
+         sector += HOST_FLASH_SECTOR_SIZE)
+    {
+        esp_partition_erase_range(partition, sector, HOST_FLASH_SECTOR_SIZE);
+    }
+    esp_err_t err = esp_partition_write(partition, ota_offset, data, size);
+    ota_offset += size;
+    return err;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+    if (!ota_open)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ota_open = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle)
+{
+    ota_open = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition) { return ESP_OK; }
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t *partition, esp_ota_img_states_t *ota_state)
+{
+    *ota_state = ESP_OTA_IMG_VALID;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void) { return ESP_OK; }
@@ -0,0 +1,391 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "ha/esp_zigbee_ha_standard.h"
+#include "host.h"
+
+/* Enough for 32 endpoints with every cluster the firmware adds */
+#define HOST_ZB_ALARMS 64
+#define HOST_ZB_ATTRIBUTE_LISTS 512
+#define HOST_ZB_ATTRIBUTE_TYPES 128
+#define HOST_ZB_ATTRIBUTES 1024
+#define HOST_ZB_ATTRIBUTE_SIZE 256
+#define HOST_ZB_REPORTING 64
+
+typedef struct
+{
+    bool used;
+    bool user;
+    int64_t due_us;
+    uint32_t seq; /* Alarms due at the same time run in the order they were set */
+    esp_zb_callback_t cb;
+    uint8_t param;
+    esp_zb_user_callback_t user_cb;
+    void *user_param;
+    esp_zb_user_cb_handle_t handle;
+} host_zb_alarm_t;
+
+struct esp_zb_attribute_list_s
+{
+    uint16_t cluster_id;
+};
+
+struct esp_zb_cluster_list_s
+{
+    uint8_t unused;
+};
+
+struct esp_zb_ep_list_s
+{
+    uint8_t unused;
+};
+
+typedef struct
+{
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint8_t type;
+} host_zb_attribute_type_t;
+
+typedef struct
+{
+    bool used;
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint8_t value[HOST_ZB_ATTRIBUTE_SIZE];
+} host_zb_attribute_t;
+
+static host_zb_alarm_t alarms[HOST_ZB_ALARMS];
+static uint32_t alarm_seq                    = 0;
+static esp_zb_user_cb_handle_t alarm_handle  = 0;
+static struct esp_zb_attribute_list_s attribute_lists[HOST_ZB_ATTRIBUTE_LISTS];
+static uint16_t attribute_list_count         = 0;
+static struct esp_zb_cluster_list_s cluster_list;
+static struct esp_zb_ep_list_s ep_list;
+static host_zb_attribute_type_t attribute_types[HOST_ZB_ATTRIBUTE_TYPES];
+static uint16_t attribute_type_count         = 0;
+static host_zb_attribute_t attributes[HOST_ZB_ATTRIBUTES];
+static esp_zb_zcl_reporting_info_t reporting[HOST_ZB_REPORTING];
+static uint8_t reporting_count               = 0;
+static host_zb_stats_t stats                 = {0};
+static host_zb_command_handler_t command_handler = NULL;
+
+static host_zb_alarm_t *host_zb_alarm_add(uint32_t time_ms)
+{
+    for (uint8_t i = 0; i < HOST_ZB_ALARMS; i++)
+    {
+        if (!alarms[i].used)
+        {
+            alarms[i] = (host_zb_alarm_t){
+                .used   = true,
+                .due_us = esp_timer_get_time() + (int64_t)time_ms * 1000,
+                .seq    = alarm_seq++,
+            };
+            return &alarms[i];
+        }
+    }
+    fprintf(stderr, "Zigbee scheduler queue full\n");
+    abort();
+}
+
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time)
+{
+    host_zb_alarm_t *alarm = host_zb_alarm_add(time);
+    alarm->cb              = cb;
+    alarm->param           = param;
+}
+
+void esp_zb_scheduler_alarm_cancel(esp_zb_callback_t cb, uint8_t param)
+{
+    for (uint8_t i = 0; i < HOST_ZB_ALARMS; i++)
+    {
+        if (alarms[i].used && !alarms[i].user && alarms[i].cb == cb && alarms[i].param == param)
+        {
+            alarms[i].used = false;
+        }
+    }
+}
+
+esp_zb_user_cb_handle_t esp_zb_scheduler_user_alarm(esp_zb_user_callback_t cb, void *param, uint32_t time)
+{
+    host_zb_alarm_t *alarm = host_zb_alarm_add(time);
+    alarm->user            = true;
+    alarm->user_cb         = cb;
+    alarm->user_param      = param;
+    alarm->handle          = ++alarm_handle;
+    return alarm->handle;
+}
+
+esp_err_t esp_zb_scheduler_user_alarm_cancel(esp_zb_user_cb_handle_t handle)
+{
+    for (uint8_t i = 0; i < HOST_ZB_ALARMS; i++)
+    {
+        if (alarms[i].used && alarms[i].user && alarms[i].handle == handle)
+        {
+            alarms[i].used = false;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static host_zb_alarm_t *host_zb_next_alarm(void)
+{
+    host_zb_alarm_t *next = NULL;
+
+    for (uint8_t i = 0; i < HOST_ZB_ALARMS; i++)
+    {
+        if (alarms[i].used && (next == NULL || alarms[i].due_us < next->due_us || (alarms[i].due_us == next->due_us && alarms[i].seq < next->seq)))
+        {
+            next = &alarms[i];
+        }
+    }
+    return next;
+}
+
+int64_t host_zb_next_alarm_us(void)
+{
+    host_zb_alarm_t *next = host_zb_next_alarm();
+    return next != NULL ? next->due_us : -1;
+}
+
+uint32_t host_zb_run_until(int64_t time_us)
+{
+    uint32_t count = 0;
+
+    for (host_zb_alarm_t *next = host_zb_next_alarm(); next != NULL && next->due_us <= time_us; next = host_zb_next_alarm())
+    {
+        /* Copied out first, the callback may set new alarms in the freed slot */
+        host_zb_alarm_t alarm = *next;
+        next->used            = false;
+
+        if (alarm.due_us > esp_timer_get_time())
+        {
+            host_tasks_wait_idle();
+        }
+        host_clock_advance_to(alarm.due_us);
+        if (alarm.user)
+        {
+            alarm.user_cb(alarm.user_param);
+        }
+        else
+        {
+            alarm.cb(alarm.param);
+        }
+        count++;
+    }
+    host_clock_advance_to(time_us);
+    return count;
+}
+
+host_zb_stats_t *host_zb_get_stats(void) { return &stats; }
+
+void host_zb_set_command_handler(host_zb_command_handler_t handler) { command_handler = handler; }
+
+esp_zb_attribute_list_t *esp_zb_zcl_attr_list_create(uint16_t cluster_id)
+{
+    if (attribute_list_count == HOST_ZB_ATTRIBUTE_LISTS)
+    {
+        fprintf(stderr, "Out of attribute lists\n");
+        abort();
+    }
+    attribute_lists[attribute_list_count].cluster_id = cluster_id;
+    return &attribute_lists[attribute_list_count++];
+}
+
+static void host_zb_register_type(uint16_t cluster_id, uint16_t attr_id, uint8_t type)
+{
+    for (uint16_t i = 0; i < attribute_type_count; i++)
+    {
+        if (attribute_types[i].cluster_id == cluster_id && attribute_types[i].attr_id == attr_id)
+        {
+            return;
+        }
+    }
+    if (attribute_type_count < HOST_ZB_ATTRIBUTE_TYPES)
+    {
+        attribute_types[attribute_type_count++] = (host_zb_attribute_type_t){cluster_id, attr_id, type};
+    }
+}
+
+/* Bytes of a value of the attribute, 0 when it was never added to a cluster */
+static size_t host_zb_attribute_size(uint16_t cluster_id, uint16_t attr_id, const void *value)
+{
+    for (uint16_t i = 0; i < attribute_type_count; i++)
+    {
+        if (attribute_types[i].cluster_id == cluster_id && attribute_types[i].attr_id == attr_id)
+        {
+            switch (attribute_types[i].type)
+            {
+                case ESP_ZB_ZCL_ATTR_TYPE_BOOL:
+                case ESP_ZB_ZCL_ATTR_TYPE_U8:
+                case ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM:
+                    return 1;
+                case ESP_ZB_ZCL_ATTR_TYPE_U16:
+                case ESP_ZB_ZCL_ATTR_TYPE_S16:
+                    return 2;
+                case ESP_ZB_ZCL_ATTR_TYPE_U32:
+                    return 4;
+                case ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING:
+                    return 1 + *(const uint8_t *)value;
+                default:
+                    return 0;
+            }
+        }
+    }
+    return 0;
+}
+
+esp_err_t esp_zb_custom_cluster_add_custom_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, uint8_t attr_type, uint8_t attr_access, void *value_p)
+{
+    host_zb_register_type(attr_list->cluster_id, attr_id, attr_type);
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_cluster_add_manufacturer_attr(
+    esp_zb_attribute_list_t *attr_list, uint16_t cluster_id, uint16_t attr_id, uint16_t manuf_code, uint8_t attr_type, uint8_t attr_access, void *value_p)
+{
+    host_zb_register_type(cluster_id, attr_id, attr_type);
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_cluster_list_add_custom_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask) { return ESP_OK; }
+
+esp_err_t esp_zb_cluster_list_add_diagnostics_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_cluster_list_add_ota_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask) { return ESP_OK; }
+
+esp_zb_attribute_list_t *esp_zb_ota_cluster_create(esp_zb_ota_cluster_cfg_t *ota_cfg) { return esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE); }
+
+esp_err_t esp_zb_ota_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p) { return ESP_OK; }
+
+esp_zb_cluster_list_t *esp_zb_temperature_sensor_clusters_create(esp_zb_temperature_sensor_cfg_t *temperature_sensor)
+{
+    host_zb_register_type(ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16);
+    return &cluster_list;
+}
+
+esp_zb_ep_list_t *esp_zb_ep_list_create(void) { return &ep_list; }
+
+esp_err_t esp_zb_ep_list_add_ep(esp_zb_ep_list_t *ep_list, esp_zb_cluster_list_t *cluster_list, esp_zb_endpoint_config_t endpoint_config) { return ESP_OK; }
+
+esp_err_t esp_zb_device_register(esp_zb_ep_list_t *ep_list) { return ESP_OK; }
+
+static host_zb_attribute_t *host_zb_find_attribute(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, bool create)
+{
+    host_zb_attribute_t *free_slot = NULL;
+
+    for (uint16_t i = 0; i < HOST_ZB_ATTRIBUTES; i++)
+    {
+        if (attributes[i].used && attributes[i].endpoint == endpoint && attributes[i].cluster_id == cluster_id && attributes[i].attr_id == attr_id)
+        {
+            return &attributes[i];
+        }
+        if (!attributes[i].used && free_slot == NULL)
+        {
+            free_slot = &attributes[i];
+        }
+    }
+    if (!create || free_slot == NULL)
+    {
+        return NULL;
+    }
+    *free_slot = (host_zb_attribute_t){.used = true, .endpoint = endpoint, .cluster_id = cluster_id, .attr_id = attr_id};
+    return free_slot;
+}
+
+const void *host_zb_attribute(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id)
+{
+    host_zb_attribute_t *attribute = host_zb_find_attribute(endpoint, cluster_id, attr_id, false);
+    return attribute != NULL ? attribute->value : NULL;
+}
+
+esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id, void *value_p, bool check)
+{
+    stats.attribute_writes++;
+
+    size_t size = host_zb_attribute_size(cluster_id, attr_id, value_p);
+    if (size == 0 || size > HOST_ZB_ATTRIBUTE_SIZE)
+    {
+        return ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB;
+    }
+
+    host_zb_attribute_t *attribute = host_zb_find_attribute(endpoint, cluster_id, attr_id, true);
+    if (attribute == NULL)
+    {
+        return ESP_ZB_ZCL_STATUS_FAIL;
+    }
+    memcpy(attribute->value, value_p, size);
+    return ESP_ZB_ZCL_STATUS_SUCCESS;
+}
+
+esp_zb_zcl_status_t esp_zb_zcl_set_manufacturer_attribute_val(
+    uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t manuf_code, uint16_t attr_id, void *value_p, bool check)
+{
+    return esp_zb_zcl_set_attribute_val(endpoint, cluster_id, cluster_role, attr_id, value_p, check);
+}
+
+esp_zb_zcl_reporting_info_t *esp_zb_zcl_find_reporting_info(esp_zb_zcl_attr_location_info_t attr_info)
+{
+    for (uint8_t i = 0; i < reporting_count; i++)
+    {
+        if (reporting[i].ep == attr_info.endpoint_id && reporting[i].cluster_id == attr_info.cluster_id && reporting[i].attr_id == attr_info.attr_id)
+        {
+            return &reporting[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_zb_zcl_update_reporting_info(esp_zb_zcl_reporting_info_t *report_info)
+{
+    esp_zb_zcl_attr_location_info_t location = {
+        .endpoint_id = report_info->ep,
+        .cluster_id  = report_info->cluster_id,
+        .attr_id     = report_info->attr_id,
+    };
+    esp_zb_zcl_reporting_info_t *current = esp_zb_zcl_find_reporting_info(location);
+
+    if (current == NULL)
+    {
+        if (reporting_count == HOST_ZB_REPORTING)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        current = &reporting[reporting_count++];
+    }
+    *current = *report_info;
+    return ESP_OK;
+}
+
+uint8_t esp_zb_zcl_report_attr_cmd_req(esp_zb_zcl_report_attr_cmd_t *cmd_req)
+{
+    stats.reports++;
+    return 0;
+}
+
+uint8_t esp_zb_zcl_custom_cluster_cmd_req(esp_zb_zcl_custom_cluster_cmd_req_t *cmd_req)
+{
+    stats.commands++;
+    stats.command_bytes += cmd_req->data.size;
+    if (command_handler != NULL)
+    {
+        command_handler(cmd_req);
+    }
+    return 0;
+}
+
+void esp_zb_sleep_enable(bool enable) {}
+
+void esp_zb_set_rx_on_when_idle(bool rx_on) {}
+
+void esp_zb_sleep_now(void) {}
+
+void esp_zb_zdo_pim_set_long_poll_interval(uint32_t ms) {}
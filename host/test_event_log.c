@@ -0,0 +1,138 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "config.h"
+#include "event_log.h"
+#include "host.h"
+
+/*
+ * The event log with its formatter running as a thread: records paced to the ring come out complete and in
+ * order, a burst larger than the ring drops records but never reorders or duplicates them, and recording
+ * costs a fraction of formatting the same line on the hot path as ESP_LOGI did. Temperatures below zero
+ * keep their sign whole, -0.50 °C included.
+ */
+
+#define TEST_RECORDS (EVENT_LOG_SIZE * 80) /* Whole half-ring bursts */
+#define TEST_BURST (EVENT_LOG_SIZE * 4)
+
+static atomic_uint formatted    = 0;
+static atomic_int last_value    = -1;
+static atomic_bool out_of_order = false;
+static atomic_bool sign_phase   = false;
+static char sign_texts[3][64];
+
+/* Called on the formatter thread for each line */
+static void test_log_line(esp_log_level_t level, const char *tag, const char *line)
+{
+    const char *text = strstr(line, "Updated temperature for endpoint ");
+    int ep, degrees, hundredths;
+
+    if (text == NULL || sscanf(text, "Updated temperature for endpoint %d: %d.%d", &ep, &degrees, &hundredths) != 3)
+    {
+        return;
+    }
+    if (atomic_load(&sign_phase))
+    {
+        snprintf(sign_texts[atomic_load(&formatted) % 3], sizeof(sign_texts[0]), "%.*s", (int)strcspn(text, "\n"), text);
+        atomic_fetch_add(&formatted, 1);
+        return;
+    }
+
+    int value = degrees * 100 + hundredths;
+    if (value <= atomic_load(&last_value) || ep != value % 32 + 1)
+    {
+        atomic_store(&out_of_order, true);
+    }
+    atomic_store(&last_value, value);
+    atomic_fetch_add(&formatted, 1);
+}
+
+static int64_t test_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void test_wait_formatted(uint32_t count)
+{
+    struct timespec pause = {.tv_nsec = 100000};
+    for (uint32_t i = 0; atomic_load(&formatted) + event_log_dropped() < count && i < 100000; i++)
+    {
+        nanosleep(&pause, NULL);
+    }
+}
+
+int main(void)
+{
+    host_log_set_handler(test_log_line);
+    ESP_ERROR_CHECK(event_log_init());
+
+    /* Half a ring at a time, then wait for the formatter like a cycle gives it time between two bursts */
+    int64_t record_ns = 0;
+    for (int32_t value = 0; value < TEST_RECORDS; value += EVENT_LOG_SIZE / 2)
+    {
+        int64_t started_ns = test_now_ns();
+        for (int32_t i = value; i < value + EVENT_LOG_SIZE / 2; i++)
+        {
+            event_log_record(EVENT_LOG_TEMPERATURE_UPDATED, i % 32 + 1, 0, i);
+        }
+        record_ns += test_now_ns() - started_ns;
+        test_wait_formatted(value + EVENT_LOG_SIZE / 2);
+    }
+    uint32_t paced_formatted = atomic_load(&formatted);
+    uint32_t paced_dropped   = event_log_dropped();
+
+    /* The same line formatted on the spot, without the UART it went to */
+    char line[128];
+    int64_t started_ns = test_now_ns();
+    for (int32_t i = 0; i < TEST_RECORDS; i++)
+    {
+        snprintf(
+            line,
+            sizeof(line),
+            "I (%lu) %s: Updated temperature for endpoint %d: %i.%02i°C\n",
+            (unsigned long)i,
+            "thermometer.c",
+            i % 32 + 1,
+            i / 100,
+            i % 100);
+    }
+    int64_t format_ns = test_now_ns() - started_ns;
+
+    for (int32_t i = TEST_RECORDS; i < TEST_RECORDS + TEST_BURST; i++)
+    {
+        event_log_record(EVENT_LOG_TEMPERATURE_UPDATED, i % 32 + 1, 0, i);
+    }
+    test_wait_formatted(TEST_RECORDS + TEST_BURST);
+    uint32_t burst_formatted = atomic_load(&formatted) - paced_formatted;
+    uint32_t burst_dropped   = event_log_dropped() - paced_dropped;
+
+    /* Below zero the sign is printed once, also when the whole degrees are 0 */
+    const int32_t signs[]  = {-50, -1234, 5};
+    const char *expected[] = {"endpoint 1: -0.50°C", "endpoint 1: -12.34°C", "endpoint 1: 0.05°C"};
+    uint32_t sign_started  = atomic_load(&formatted);
+    bool sign_kept         = true;
+    atomic_store(&sign_phase, true);
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        event_log_record(EVENT_LOG_TEMPERATURE_UPDATED, 1, 0, signs[i]);
+    }
+    test_wait_formatted(sign_started + 3 + event_log_dropped());
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        const char *text = sign_texts[(sign_started + i) % 3];
+        sign_kept &= strstr(text, expected[i]) != NULL;
+        printf("sign           %s\n", text);
+    }
+
+    printf("paced          %lu of %d records formatted, %lu dropped\n", (unsigned long)paced_formatted, TEST_RECORDS, (unsigned long)paced_dropped);
+    printf("burst          %lu of %d records formatted, %lu dropped\n", (unsigned long)burst_formatted, TEST_BURST, (unsigned long)burst_dropped);
+    printf("order          %s\n", atomic_load(&out_of_order) ? "broken" : "kept");
+    printf("host CPU       %.1f ns to record, %.1f ns to format in place\n", (double)record_ns / TEST_RECORDS, (double)format_ns / TEST_RECORDS);
+
+    bool delivered = paced_formatted == TEST_RECORDS && paced_dropped == 0 && burst_formatted + burst_dropped == TEST_BURST;
+    return delivered && !atomic_load(&out_of_order) && sign_kept ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "esp_partition.h"
+#include "harness.h"
+#include "history.h"
+#include "host.h"
+
+/*
+ * The history ring on file-backed flash: compression of the stored readings, flash programmed and erased
+ * per encoded byte once the ring has wrapped, and how fast a fetch of one endpoint streams back.
+ */
+
+#define TEST_SENSORS 8
+#define TEST_CYCLES 8000 /* Eleven hours of readings, the 64 KiB ring wraps twice */
+#define TEST_ENDPOINT DS18B20_FIRST_ENDPOINT
+#define TEST_REQUESTER 0x1234
+
+static uint32_t fetched_samples = 0;
+static uint32_t fetched_bytes   = 0;
+static uint32_t fetched_time    = 0;
+static bool fetch_done          = false;
+static bool fetch_valid         = true;
+
+static void test_samples(const esp_zb_zcl_custom_cluster_cmd_req_t *cmd_req)
+{
+    const uint8_t *frame = cmd_req->data.value;
+    uint8_t count        = frame[2];
+
+    if (cmd_req->cluster_id != HISTORY_CLUSTER_ID || cmd_req->zcl_basic_cmd.dst_addr_u.addr_short != TEST_REQUESTER || frame[1] != TEST_ENDPOINT)
+    {
+        fetch_valid = false;
+        return;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint32_t time;
+        int16_t value;
+        memcpy(&time, &frame[3 + i * 6], sizeof(time));
+        memcpy(&value, &frame[3 + i * 6 + 4], sizeof(value));
+
+        /* The first simulated sensor stays within 20.00..23.00 °C, samples come oldest first */
+        if (time < fetched_time || value < 2000 || value > 2300)
+        {
+            fetch_valid = false;
+        }
+        fetched_time = time;
+    }
+    fetched_samples += count;
+    fetched_bytes += cmd_req->data.size;
+    fetch_done = count == 0;
+}
+
+int main(void)
+{
+    harness_start(TEST_SENSORS);
+    host_zb_set_command_handler(test_samples);
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, 0x40, "history");
+    const history_stats_t *stats     = history_get_stats();
+    const host_flash_stats_t *flash  = host_partition_get_stats(partition);
+
+    for (uint32_t i = 0; i < TEST_CYCLES; i++)
+    {
+        if (!harness_run_cycle())
+        {
+            fprintf(stderr, "the scheduler ran dry after %lu cycles\n", (unsigned long)i);
+            return 1;
+        }
+    }
+
+    printf("sensors %d, cycles %d, %lu readings stored\n", TEST_SENSORS, TEST_CYCLES, (unsigned long)stats->samples);
+    printf(
+        "compression          %6.2f : 1 (%lu raw bytes, %lu encoded)\n",
+        (double)stats->raw_bytes / stats->encoded_bytes,
+        (unsigned long)stats->raw_bytes,
+        (unsigned long)stats->encoded_bytes);
+    printf(
+        "write amplification  %6.3f programmed, %6.3f erased per encoded byte, %lu erases of %lu blocks\n",
+        (double)flash->written_bytes / stats->encoded_bytes,
+        (double)flash->erased_bytes / stats->encoded_bytes,
+        (unsigned long)flash->erases,
+        (unsigned long)(partition->size / partition->erase_size));
+
+    uint8_t request[9] = {TEST_ENDPOINT};
+    uint32_t to        = UINT32_MAX;
+    memcpy(&request[5], &to, sizeof(to));
+    esp_zb_zcl_custom_cluster_command_message_t message = {
+        .info.src_address.addr_type    = ESP_ZB_ZCL_ADDR_TYPE_SHORT,
+        .info.src_address.u.short_addr = TEST_REQUESTER,
+        .info.src_endpoint             = 1,
+        .info.dst_endpoint             = TEST_ENDPOINT,
+        .info.cluster                  = HISTORY_CLUSTER_ID,
+        .info.command.id               = HISTORY_CMD_FETCH_ID,
+        .data.type                     = ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+        .data.size                     = sizeof(request),
+        .data.value                    = request,
+    };
+    if (history_handle_command(&message) != ESP_OK)
+    {
+        fprintf(stderr, "the fetch was refused\n");
+        return 1;
+    }
+    while (!fetch_done && host_zb_next_alarm_us() >= 0)
+    {
+        host_zb_run_until(host_zb_next_alarm_us());
+    }
+
+    double fetch_s = stats->fetch_time_us / 1e6;
+    printf(
+        "fetch                %lu samples in %lu frames, %.1f s, %.1f samples/s, %.0f bytes/s\n",
+        (unsigned long)fetched_samples,
+        (unsigned long)stats->fetch_frames,
+        fetch_s,
+        fetched_samples / fetch_s,
+        fetched_bytes / fetch_s);
+
+    /* Every programmed byte is one the history accounted for, and blocks are erased only as the ring turns */
+    bool in_order = flash->written_bytes == stats->flash_bytes && flash->erases <= stats->erases;
+    return fetch_done && fetch_valid && fetched_samples > 0 && in_order && stats->raw_bytes > stats->encoded_bytes ? 0 : 1;
+}
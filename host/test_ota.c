@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "host.h"
+#include "ota.h"
+#include "ota_heatshrink.h"
+
+/*
+ * An OTA file received in Image Block payloads, once with the plain image element and once with the image
+ * compressed like heatshrink -e -w 12 -l 4 does. The partition has to hold the image byte for byte either
+ * way, and the bytes on air of both runs are printed against the bytes written. The image is a host
+ * executable given on the command line, machine code and tables compress about like the firmware does.
+ */
+
+#define TEST_PARTITION_SIZE (1024 * 1024)
+#define TEST_BLOCK_SIZE 64 /* Image Block payload the OTA server sends */
+#define TEST_HEADER_SIZE 6 /* Element tag and length */
+#define TEST_MATCH_MIN 2   /* A back-reference of 17 bits beats two 9-bit literals */
+#define TEST_MATCH_MAX (1 << OTA_HEATSHRINK_LOOKAHEAD_BITS)
+#define TEST_WINDOW (1 << OTA_HEATSHRINK_WINDOW_BITS)
+#define TEST_CHAIN_MAX 256
+
+typedef struct
+{
+    uint8_t *data;
+    size_t len;
+    uint8_t byte;
+    uint8_t bit_count;
+} test_bits_t;
+
+static uint8_t image[TEST_PARTITION_SIZE];
+static uint8_t written[TEST_PARTITION_SIZE];
+static uint8_t file[TEST_HEADER_SIZE + TEST_PARTITION_SIZE * 9 / 8 + 1];
+static int32_t chain_head[1 << 16];
+static int32_t chain_prev[TEST_WINDOW];
+
+static void test_put_bits(test_bits_t *out, uint16_t value, uint8_t count)
+{
+    while (count-- > 0)
+    {
+        out->byte = out->byte << 1 | ((value >> count) & 1);
+        if (++out->bit_count == 8)
+        {
+            out->data[out->len++] = out->byte;
+            out->bit_count        = 0;
+        }
+    }
+}
+
+/* Greedy encoder for the decoder's bit stream, matches are found through chains of two-byte prefixes */
+static size_t test_compress(const uint8_t *data, size_t len, uint8_t *compressed)
+{
+    test_bits_t out = {.data = compressed};
+
+    memset(chain_head, 0xFF, sizeof(chain_head));
+    for (size_t pos = 0; pos < len;)
+    {
+        size_t best_len = 0;
+        size_t best_pos = 0;
+        if (pos + TEST_MATCH_MIN <= len)
+        {
+            int32_t candidate = chain_head[data[pos] << 8 | data[pos + 1]];
+            for (uint16_t n = 0; candidate >= 0 && pos - candidate <= TEST_WINDOW && n < TEST_CHAIN_MAX; n++)
+            {
+                size_t match = 0;
+                while (match < TEST_MATCH_MAX && pos + match < len && data[candidate + match] == data[pos + match])
+                {
+                    match++;
+                }
+                if (match > best_len)
+                {
+                    best_len = match;
+                    best_pos = candidate;
+                }
+                candidate = chain_prev[candidate % TEST_WINDOW];
+            }
+        }
+
+        size_t step = best_len >= TEST_MATCH_MIN ? best_len : 1;
+        if (step > 1)
+        {
+            test_put_bits(&out, 0, 1);
+            test_put_bits(&out, pos - best_pos - 1, OTA_HEATSHRINK_WINDOW_BITS);
+            test_put_bits(&out, best_len - 1, OTA_HEATSHRINK_LOOKAHEAD_BITS);
+        }
+        else
+        {
+            test_put_bits(&out, 1, 1);
+            test_put_bits(&out, data[pos], 8);
+        }
+
+        for (; step > 0; step--, pos++)
+        {
+            if (pos + 1 < len)
+            {
+                uint16_t prefix               = data[pos] << 8 | data[pos + 1];
+                chain_prev[pos % TEST_WINDOW] = chain_head[prefix];
+                chain_head[prefix]            = pos;
+            }
+        }
+    }
+    if (out.bit_count > 0)
+    {
+        test_put_bits(&out, 0, 8 - out.bit_count);
+    }
+    return out.len;
+}
+
+static esp_err_t test_upgrade(esp_zb_zcl_ota_upgrade_status_t status, uint8_t *payload, uint16_t payload_size, uint32_t image_size)
+{
+    esp_zb_zcl_ota_upgrade_value_message_t message = {
+        .info.status           = ESP_ZB_ZCL_STATUS_SUCCESS,
+        .upgrade_status        = status,
+        .ota_header.image_size = image_size,
+        .payload_size          = payload_size,
+        .payload               = payload,
+    };
+    return ota_handle_upgrade(&message);
+}
+
+/* Sends one element holding the image, returns true when the partition holds the image afterwards */
+static bool test_transfer(const char *name, uint16_t tag, const uint8_t *element, size_t element_len, size_t image_len)
+{
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    size_t file_len                  = TEST_HEADER_SIZE + element_len;
+
+    file[0] = tag & 0xFF;
+    file[1] = tag >> 8;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        file[2 + i] = element_len >> (i * 8);
+    }
+    memmove(&file[TEST_HEADER_SIZE], element, element_len);
+
+    esp_err_t err = test_upgrade(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START, NULL, 0, file_len);
+    for (size_t offset = 0; offset < file_len && err == ESP_OK; offset += TEST_BLOCK_SIZE)
+    {
+        size_t block = file_len - offset < TEST_BLOCK_SIZE ? file_len - offset : TEST_BLOCK_SIZE;
+        err          = test_upgrade(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE, &file[offset], block, file_len);
+    }
+    if (err == ESP_OK)
+    {
+        err = test_upgrade(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK, NULL, 0, file_len);
+    }
+
+    const ota_stats_t *stats = ota_get_stats();
+    bool stored              = err == ESP_OK && stats->bytes_written == image_len &&
+                  esp_partition_read(partition, 0, written, image_len) == ESP_OK && memcmp(written, image, image_len) == 0;
+    printf(
+        "%-10s %7lu bytes on air in %5lu blocks, %7lu bytes written, %5.1f%% of the image on air, %s\n",
+        name,
+        (unsigned long)stats->bytes_on_air,
+        (unsigned long)((file_len + TEST_BLOCK_SIZE - 1) / TEST_BLOCK_SIZE),
+        (unsigned long)stats->bytes_written,
+        stats->bytes_written ? 100.0 * stats->bytes_on_air / stats->bytes_written : 0.0,
+        stored ? "stored" : "corrupt");
+    return stored;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *source = fopen(argc > 1 ? argv[1] : argv[0], "rb");
+    if (source == NULL)
+    {
+        fprintf(stderr, "usage: %s [image]\n", argv[0]);
+        return 1;
+    }
+    size_t image_len = fread(image, 1, sizeof(image), source);
+    fclose(source);
+
+    host_partition_add("ota_1", ESP_PARTITION_TYPE_APP, 0x11, TEST_PARTITION_SIZE);
+
+    static uint8_t compressed[TEST_PARTITION_SIZE * 9 / 8 + 1];
+    size_t compressed_len = test_compress(image, image_len, compressed);
+
+    bool passed = test_transfer("plain", OTA_TAG_UPGRADE_IMAGE, image, image_len, image_len);
+    passed &= test_transfer("heatshrink", OTA_TAG_HEATSHRINK_IMAGE, compressed, compressed_len, image_len);
+
+    return passed && compressed_len < image_len ? 0 : 1;
+}
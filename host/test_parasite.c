@@ -0,0 +1,91 @@
+#include <stdio.h>
+
+#include "config.h"
+#include "device_config.h"
+#include "harness.h"
+#include "onewire_sim.h"
+#include "thermometer.h"
+
+/*
+ * Strong pullup timing on a parasite-powered bus: every cycle the bus has to be driven for the conversion
+ * time of its resolution, and released right then, before and after the resolution changes. The simulator
+ * fails a conversion whose power goes away early, which would show up as a cut conversion and a re-read.
+ * A device-wide resolution reaches each sensor once, during the cycle after it was set.
+ */
+
+#define TEST_SENSORS 8
+#define TEST_CYCLES 24
+#define TEST_MAX_LATE_US 1000
+
+static bool test_cycles(uint8_t resolution)
+{
+    const thermometer_stats_t *stats = thermometer_get_stats();
+    const onewire_sim_stats_t *sim   = onewire_sim_get_stats(GPIO_NUM_1);
+    uint32_t conversion_us           = DS18B20_CONVERSION_TIME_MS(resolution) * 1000;
+    uint32_t min_pullup_us           = UINT32_MAX;
+    uint32_t max_pullup_us           = 0;
+    uint32_t read_failures           = 0;
+
+    for (uint32_t i = 0; i < TEST_CYCLES; i++)
+    {
+        if (!harness_run_cycle())
+        {
+            fprintf(stderr, "the scheduler ran dry after %lu cycles\n", (unsigned long)i);
+            return false;
+        }
+        min_pullup_us = stats->pullup_time_us < min_pullup_us ? stats->pullup_time_us : min_pullup_us;
+        max_pullup_us = stats->pullup_time_us > max_pullup_us ? stats->pullup_time_us : max_pullup_us;
+        read_failures += stats->read_failures;
+    }
+
+    printf(
+        "%d bit: conversion %6lu us, strong pullup %6lu..%6lu us per cycle, %lu us late at most, %lu conversions cut, %lu read failures\n",
+        resolution,
+        (unsigned long)conversion_us,
+        (unsigned long)min_pullup_us,
+        (unsigned long)max_pullup_us,
+        (unsigned long)stats->pullup_late_us,
+        (unsigned long)sim->conversions_cut,
+        (unsigned long)read_failures);
+
+    return min_pullup_us >= conversion_us && max_pullup_us <= conversion_us + TEST_MAX_LATE_US && stats->pullup_late_us <= TEST_MAX_LATE_US &&
+           sim->conversions_cut == 0 && read_failures == 0;
+}
+
+int main(void)
+{
+    onewire_sim_set_parasite(GPIO_NUM_1, true);
+    harness_start(TEST_SENSORS);
+
+    if (!test_cycles(DS18B20_RESOLUTION))
+    {
+        return 1;
+    }
+
+    /* The coordinator lowers the resolution between two cycles, the next cycle writes it after each read and the
+       pullup of every cycle after that has to follow */
+    uint8_t resolution                          = 10;
+    esp_zb_zcl_set_attr_value_message_t message = {
+        .info.dst_endpoint    = DS18B20_FIRST_ENDPOINT,
+        .info.cluster         = DEVICE_CONFIG_CLUSTER_ID,
+        .attribute.id         = DEVICE_CONFIG_ATTR_RESOLUTION_ID,
+        .attribute.data.type  = ESP_ZB_ZCL_ATTR_TYPE_U8,
+        .attribute.data.size  = sizeof(resolution),
+        .attribute.data.value = &resolution,
+    };
+    const onewire_sim_stats_t *sim = onewire_sim_get_stats(GPIO_NUM_1);
+    uint32_t writes                = sim->writes;
+    if (thermometer_set_attribute(&message) != ESP_OK || sim->writes != writes)
+    {
+        fprintf(stderr, "the resolution was refused or written from the attribute callback\n");
+        return 1;
+    }
+    if (!harness_run_cycle())
+    {
+        fprintf(stderr, "the scheduler ran dry\n");
+        return 1;
+    }
+    printf("resolution     %lu sensors written in the cycle after the change\n", (unsigned long)(sim->writes - writes));
+
+    return sim->writes - writes == TEST_SENSORS && test_cycles(resolution) ? 0 : 1;
+}
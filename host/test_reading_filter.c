@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "esp_pm.h"
+#include "esp_random.h"
+#include "host.h"
+#include "reading_filter.h"
+
+/*
+ * Reports a sensor sends with the default reporting configuration on a noisy trace, unfiltered and through
+ * each filter stage, and the cost of a filtered sample. The trace is 12-bit readings of a slow room drift
+ * with one LSB of conversion noise and short bursts of interference as seen on long unshielded runs.
+ */
+
+#define TEST_SAMPLES 1440 /* Two hours at the default update interval */
+#define TEST_SPIKE_PER_MILLE 5
+#define TEST_SAMPLE_PERIOD_S (DS18B20_UPDATE_INTERVAL / 1000)
+
+static int16_t trace[TEST_SAMPLES];
+
+static void test_make_trace(void)
+{
+    host_seed(0x18b20);
+    for (uint16_t i = 0; i < TEST_SAMPLES; i++)
+    {
+        /* 0.4 °C up and down once an hour around 21 °C, in 1/16 °C like the scratchpad */
+        int32_t phase  = i % (TEST_SAMPLES / 2);
+        int32_t drift  = phase < TEST_SAMPLES / 4 ? phase : TEST_SAMPLES / 2 - phase;
+        int32_t raw    = 21 * 16 + drift * 16 * 40 / 100 / (TEST_SAMPLES / 4);
+        uint32_t noise = esp_random() % 4;
+        raw += noise == 0 ? -1 : noise == 3 ? 1 : 0;
+        if (esp_random() % 1000 < TEST_SPIKE_PER_MILLE)
+        {
+            raw += (esp_random() % 2 ? 1 : -1) * (16 + esp_random() % 32);
+        }
+        trace[i] = (int16_t)(raw * 25 / 4);
+    }
+}
+
+/* Reporting as configured by thermometer_configure_reporting(): a change of at least the reportable change once the
+   minimum interval passed, or the current value once the maximum interval passed */
+static uint32_t test_reports(const reading_filter_config_t *config)
+{
+    reading_filter_t filter;
+    uint32_t reports     = 0;
+    int16_t value        = 0;
+    int16_t reported     = 0;
+    uint32_t reported_at = 0;
+
+    reading_filter_reset(&filter);
+    for (uint16_t i = 0; i < TEST_SAMPLES; i++)
+    {
+        int16_t sample = trace[i];
+        if (reading_filter_apply(&filter, config, &sample))
+        {
+            value = sample;
+        }
+
+        uint32_t now_s = i * TEST_SAMPLE_PERIOD_S;
+        if (i == 0 || (now_s - reported_at >= DS18B20_REPORT_MIN_INTERVAL && abs(value - reported) >= DS18B20_REPORTABLE_CHANGE) ||
+            now_s - reported_at >= DS18B20_REPORT_MAX_INTERVAL)
+        {
+            reports++;
+            reported    = value;
+            reported_at = now_s;
+        }
+    }
+    return reports;
+}
+
+int main(void)
+{
+    const struct
+    {
+        const char *name;
+        reading_filter_config_t config;
+    } filters[] = {
+        {"none", {.median_size = 1}},
+        {"median 3", {.median_size = 3}},
+        {"median 5", {.median_size = 5}},
+        {"ema 1/4", {.median_size = 1, .ema_shift = 2}},
+        {"spike 0.5 C", {.median_size = 1, .spike_threshold = 50}},
+        {"all", {.median_size = 3, .ema_shift = 2, .spike_threshold = 50}},
+    };
+    uint32_t reports[sizeof(filters) / sizeof(filters[0])];
+
+    test_make_trace();
+    for (uint8_t i = 0; i < sizeof(filters) / sizeof(filters[0]); i++)
+    {
+        const reading_filter_stats_t *stats = reading_filter_get_stats();
+        uint32_t samples                    = stats->samples;
+        uint32_t cpu_cycles                 = stats->cpu_cycles;
+
+        reports[i] = test_reports(&filters[i].config);
+        printf(
+            "%-12s %5lu reports, %6.1f cycles/sample\n",
+            filters[i].name,
+            (unsigned long)reports[i],
+            (double)(stats->cpu_cycles - cpu_cycles) / (stats->samples - samples));
+    }
+    printf("cycles are host time at %d MHz and include reading the cycle counter twice\n", CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+
+    /* The full pipeline has to cut the reports caused by noise at least in half */
+    uint8_t all = sizeof(filters) / sizeof(filters[0]) - 1;
+    return reports[all] * 2 <= reports[0] ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_random.h"
+#include "host.h"
+#include "onewire.h"
+#include "onewire_rmt_codec.h"
+
+/*
+ * The RMT symbol codec: write and read slots have to decode back to the bytes they carry, and the host CPU
+ * time to encode and decode a byte is printed. Under radio interrupt load the bit-banged backend
+ * stretches the low part of a slot by the interrupt latency, past the sample point a 1 reads as a 0. The
+ * RMT peripheral times the slots of a transaction on its own, an interrupt only holds back the start of
+ * the next transaction while the line idles high. The strong pullup of the RMT backend has to drive the
+ * line high and hand the pin back to the TX channel when released.
+ */
+
+#define TEST_BYTES 4096
+#define TEST_BITS (TEST_BYTES * 8)
+#define TEST_DEVICE_HOLD_MIN 20 /* A DS18B20 answering 0 holds the line low for 15..60 us from the slot start */
+#define TEST_DEVICE_HOLD_MAX 45
+#define TEST_IRQ_LATENCY_MAX 60 /* Longest radio interrupt handler, in us */
+#define TEST_TRANSACTION_BITS (9 * 8) /* Match ROM, the longest RMT transaction */
+#define TEST_PULLUP_PIN GPIO_NUM_2
+
+static uint8_t data[TEST_BYTES];
+static uint8_t decoded[TEST_BYTES];
+static uint8_t ones[TEST_BYTES];
+static onewire_rmt_symbol_t symbols[TEST_BITS];
+static onewire_rmt_symbol_t rmt_symbols[TEST_BITS];
+
+static uint32_t test_bit_errors(void)
+{
+    uint32_t errors = 0;
+    for (size_t i = 0; i < TEST_BITS; i++)
+    {
+        errors += ((data[i / 8] ^ decoded[i / 8]) >> (i % 8)) & 1;
+    }
+    return errors;
+}
+
+/* Read slots are all 1 slots from the master, a device sending 0 stretches the low part of the capture */
+static void test_device_answers(void)
+{
+    memset(ones, 0xFF, sizeof(ones));
+    onewire_rmt_encode_bits(symbols, ones, TEST_BITS);
+    for (size_t i = 0; i < TEST_BITS; i++)
+    {
+        if (!(data[i / 8] & (1 << (i % 8))))
+        {
+            uint16_t hold        = TEST_DEVICE_HOLD_MIN + esp_random() % (TEST_DEVICE_HOLD_MAX - TEST_DEVICE_HOLD_MIN + 1);
+            symbols[i].duration1 = symbols[i].duration0 + symbols[i].duration1 - hold;
+            symbols[i].duration0 = hold;
+        }
+    }
+}
+
+/*
+ * A bit-banged slot is as long as the interrupt that hit it keeps the CPU from releasing the line. The same
+ * interrupt on the RMT path delays the task starting the next transaction, the idle time before it grows.
+ */
+static void test_interrupt_load(uint32_t irq_per_mille)
+{
+    memcpy(rmt_symbols, symbols, sizeof(rmt_symbols));
+    for (size_t i = 0; i < TEST_BITS; i++)
+    {
+        if (esp_random() % 1000 < irq_per_mille)
+        {
+            uint16_t latency = esp_random() % (TEST_IRQ_LATENCY_MAX + 1);
+            size_t last      = (i / TEST_TRANSACTION_BITS + 1) * TEST_TRANSACTION_BITS - 1;
+            symbols[i].duration0 += latency;
+            rmt_symbols[last < TEST_BITS ? last : TEST_BITS - 1].duration1 += latency;
+        }
+    }
+}
+
+/* The line while the strong pullup is on and after its release, with the bytes of a Convert T in between */
+static bool test_strong_pullup(void)
+{
+    static onewire_bus_t bus;
+    if (onewire_init(&bus, &onewire_rmt_backend, TEST_PULLUP_PIN) != ESP_OK)
+    {
+        return false;
+    }
+
+    static const char *drives[] = {"low", "released", "driven high"};
+    const uint8_t convert[]     = {ONEWIRE_CMD_SKIP_ROM, DS18B20_CMD_CONVERT_T};
+    onewire_write_bytes(&bus, convert, sizeof(convert));
+    bus.backend->strong_pullup(&bus, true);
+    host_gpio_drive_t during = host_gpio_drive(TEST_PULLUP_PIN);
+    bool routed_during       = host_gpio_rmt_routed(TEST_PULLUP_PIN);
+    bus.backend->strong_pullup(&bus, false);
+    host_gpio_drive_t after = host_gpio_drive(TEST_PULLUP_PIN);
+    bool routed_after       = host_gpio_rmt_routed(TEST_PULLUP_PIN);
+
+    printf("strong pullup  line %s while on, %s after\n", drives[during], drives[after]);
+    return during == HOST_GPIO_HIGH && after == HOST_GPIO_RELEASED && routed_during && routed_after;
+}
+
+static int64_t test_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+int main(void)
+{
+    bool passed = true;
+
+    host_seed(0x1b1e);
+    for (size_t i = 0; i < TEST_BYTES; i++)
+    {
+        data[i] = esp_random();
+    }
+
+    /* The RX channel captures our own write slots */
+    int64_t started_ns = test_now_ns();
+    onewire_rmt_encode_bits(symbols, data, TEST_BITS);
+    int64_t encoded_ns = test_now_ns();
+    passed &= onewire_rmt_decode_bits(symbols, TEST_BITS, decoded, TEST_BITS);
+    int64_t decoded_ns    = test_now_ns();
+    uint32_t write_errors = test_bit_errors();
+
+    test_device_answers();
+    passed &= onewire_rmt_decode_bits(symbols, TEST_BITS, decoded, TEST_BITS);
+    uint32_t read_errors = test_bit_errors();
+
+    printf("round trip     %lu write and %lu read bit errors in %d bytes\n", (unsigned long)write_errors, (unsigned long)read_errors, TEST_BYTES);
+    printf(
+        "host CPU       %.1f ns/byte to encode, %.1f ns/byte to decode\n",
+        (double)(encoded_ns - started_ns) / TEST_BYTES,
+        (double)(decoded_ns - encoded_ns) / TEST_BYTES);
+    passed &= write_errors == 0 && read_errors == 0;
+
+    const uint32_t loads[] = {10, 50, 200};
+    for (uint8_t i = 0; i < sizeof(loads) / sizeof(loads[0]); i++)
+    {
+        onewire_rmt_encode_bits(symbols, data, TEST_BITS);
+        test_interrupt_load(loads[i]);
+
+        onewire_rmt_decode_bits(symbols, TEST_BITS, decoded, TEST_BITS);
+        uint32_t gpio_errors = test_bit_errors();
+        onewire_rmt_decode_bits(rmt_symbols, TEST_BITS, decoded, TEST_BITS);
+        uint32_t rmt_errors = test_bit_errors();
+
+        printf(
+            "%4.1f%% of slots hit by an interrupt: BER %.2e bit-banged, %.2e RMT\n",
+            loads[i] / 10.0,
+            (double)gpio_errors / TEST_BITS,
+            (double)rmt_errors / TEST_BITS);
+        passed &= rmt_errors == 0;
+    }
+
+    passed &= test_strong_pullup();
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#include <stdio.h>
+
+#include "config.h"
+#include "harness.h"
+#include "onewire_sim.h"
+#include "thermometer.h"
+
+/*
+ * Longest time a measurement alarm keeps the Zigbee task per cycle. Blocking in Convert T held it for the
+ * conversion time plus every scratchpad read; split phase, each alarm does one bus transaction or a slice
+ * of reads and the stack polls its parent in between.
+ */
+
+#define TEST_SENSORS 32
+#define TEST_CYCLES 24
+/* A slice may run over by one transaction: reset, Match ROM, Read Scratchpad and the nine scratchpad bytes */
+#define TEST_TRANSACTION_US (ONEWIRE_SIM_RESET_US + (1 + 8 + 1 + 9) * 8 * ONEWIRE_SIM_SLOT_US)
+#define TEST_MAX_HOLD_US (DS18B20_READ_SLICE_US + TEST_TRANSACTION_US)
+
+int main(void)
+{
+    harness_start(TEST_SENSORS);
+
+    const thermometer_stats_t *stats = thermometer_get_stats();
+    uint32_t max_hold_us             = 0;
+    uint32_t max_blocking_us         = 0;
+
+    for (uint32_t i = 0; i < TEST_CYCLES; i++)
+    {
+        if (!harness_run_cycle())
+        {
+            fprintf(stderr, "the scheduler ran dry after %lu cycles\n", (unsigned long)i);
+            return 1;
+        }
+        /* What a blocking cycle would have held: the conversion wait and all the bus traffic in one go */
+        uint32_t blocking_us = DS18B20_CONVERSION_TIME_MS(DS18B20_RESOLUTION) * 1000 + stats->bus_time_us;
+        max_blocking_us      = blocking_us > max_blocking_us ? blocking_us : max_blocking_us;
+        max_hold_us          = stats->stack_hold_us > max_hold_us ? stats->stack_hold_us : max_hold_us;
+    }
+
+    printf("sensors %d, cycles %d\n", TEST_SENSORS, TEST_CYCLES);
+    printf("longest stack hold, blocking   %8lu us\n", (unsigned long)max_blocking_us);
+    printf("longest stack hold, split      %8lu us\n", (unsigned long)max_hold_us);
+    printf("allowed: slice + transaction   %8lu us\n", (unsigned long)TEST_MAX_HOLD_US);
+
+    return max_hold_us <= TEST_MAX_HOLD_US ? 0 : 1;
+}
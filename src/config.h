@@ -4,12 +4,67 @@
 #define INSTALLCODE_POLICY_ENABLE false                                  /* enable the install code policy for security */
 #define ED_AGING_TIMEOUT ESP_ZB_ED_AGING_TIMEOUT_64MIN                   /* aging timeout of device */
 #define ED_KEEP_ALIVE 3000                                               /* 3000 millisecond */
+#define ZB_SLEEPY_END_DEVICE 0                                           /* sleepy end device with light sleep between cycles */
+#define ZB_COMMISSIONING_RETRY_MIN_MS 1000                               /* first steering or rejoin retry, doubled on every failure */
+#define ZB_COMMISSIONING_RETRY_MAX_MS 300000                             /* longest retry delay before the random jitter */
+#define ZB_OTA_ENABLE 1                                                  /* OTA Upgrade cluster client, images can be heatshrink-compressed */
+#define ZB_OTA_FILE_VERSION 0x00010000                                   /* version of this firmware, the server offers only newer files */
+#define ZB_OTA_IMAGE_TYPE 0x1011                                         /* image type of OTA files for this device */
+#define ZB_OTA_HW_VERSION 0x0101                                         /* hardware version sent in Query Next Image */
+#define ZB_OTA_MAX_DATA_SIZE 223                                         /* largest Image Block payload requested */
+#define ZB_MANUFACTURER_CODE 0x131B                                      /* manufacturer code of manufacturer-specific attributes */
 #define ESP_ZB_PRIMARY_CHANNEL_MASK ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK /* Zigbee primary channel mask use in the example */
 
 #define RGB_LED_GPIO GPIO_NUM_8 /* GPIO for RGB LED */
 
-#define DS18B20_GPIO GPIO_NUM_1          /* GPIO for DS18B20 */
-#define DS18B20_FIRST_ENDPOINT 1         /* First endpoint number for DS18B20 */
-#define DS18B20_READ_FAILURE_ATTEMPTS 3  /* Maximum read failure attempts before setting temperature to unknown */
-#define DS18B20_SKIP_UNCHANGED_UPDATE 60 /* Maximum number of skipping unchanged updates before force update value */
-#define DS18B20_UPDATE_INTERVAL 5000     /* Update interval in milliseconds for DS18B20 */
+#define EVENT_LOG_ENABLE 1 /* Record hot-path log lines as binary events formatted by a low-priority task, 0 logs them right away */
+
+#define POWER_ACTIVE_CURRENT_UA 25000 /* Estimated current while awake with the radio idle, for the energy estimate */
+#define POWER_SLEEP_CURRENT_UA 200    /* Estimated current in light sleep, for the energy estimate */
+
+#define DS18B20_GPIOS {GPIO_NUM_1}      /* GPIOs of the DS18B20 1-Wire buses */
+#define DS18B20_FIRST_ENDPOINT 1        /* First endpoint number for DS18B20 */
+#define DS18B20_READ_FAILURE_ATTEMPTS 1 /* Failed cycles before setting temperature to unknown, each cycle retries in place */
+#define DS18B20_REREAD_ATTEMPTS 2       /* Immediate scratchpad re-reads before a sensor is converted again in the same cycle */
+#define DS18B20_UPDATE_INTERVAL 5000    /* Update interval in milliseconds for DS18B20 */
+#define DS18B20_RESOLUTION 12           /* Default conversion resolution in bits (9..12), adjustable per endpoint */
+#define DS18B20_PARASITE_POWER_ENABLE 1 /* Detect parasite-powered buses at boot and drive them high during conversions */
+#ifndef DS18B20_BUS_BACKEND
+#define DS18B20_BUS_BACKEND onewire_gpio_backend /* 1-Wire backend: onewire_gpio_backend, onewire_rmt_backend or onewire_sim_backend */
+#endif
+#define DS18B20_SKIP_ROM_SINGLE_DROP 1 /* Address the only sensor of a bus with Skip ROM instead of Match ROM */
+#define DS18B20_FULL_READ_CYCLES 10    /* Cycles between CRC-verified full scratchpad reads of a sensor, 2 bytes in between */
+#define DS18B20_READ_SLICE_US 4000     /* Scratchpad reads in one scheduler alarm stop after this long, the rest follow in the next */
+
+#define DS18B20_SIM_DEVICES 4       /* Simulated devices per bus with onewire_sim_backend */
+#define DS18B20_SIM_PARASITE 0      /* Simulated devices answer Read Power Supply as parasite-powered */
+#define DS18B20_SIM_BIT_ERROR_PPM 0 /* Simulated bits flipped per million, models slots broken by interrupt latency */
+
+#define DS18B20_FILTER_MEDIAN_SIZE 1     /* Default median window per endpoint, 1 disables it */
+#define DS18B20_FILTER_EMA_SHIFT 0       /* Default EMA weight 1/2^shift per endpoint, 0 disables it */
+#define DS18B20_FILTER_SPIKE_THRESHOLD 0 /* Default largest accepted step in 0.01°C per endpoint, 0 disables the spike rejector */
+
+#define DS18B20_AUTO_RESOLUTION_FAST_CHANGE 50  /* Change per cycle in 0.01°C that lowers the resolution in automatic mode */
+#define DS18B20_AUTO_RESOLUTION_STABLE_CYCLES 6 /* Stable cycles before the resolution is raised again in automatic mode */
+
+#define DS18B20_REPORT_MIN_INTERVAL 10  /* Default minimum reporting interval in seconds */
+#define DS18B20_REPORT_MAX_INTERVAL 300 /* Default maximum reporting interval in seconds */
+#define DS18B20_REPORTABLE_CHANGE 10    /* Default reportable change in 0.01°C */
+
+#ifndef DS18B20_PACKED_REPORT_ENABLE
+#define DS18B20_PACKED_REPORT_ENABLE 0 /* Also report all readings in one frame of the manufacturer-specific cluster */
+#endif
+#define DS18B20_PACKED_REPORT_KEY_FRAME_INTERVAL 12 /* Packed frames between two frames carrying absolute values */
+
+#define DS18B20_HISTORY_ENABLE 1 /* Keep changed readings in the history partition for fetching over Zigbee */
+
+#define DS18B20_REDISCOVERY_ENABLE 1         /* Search the buses one ROM per cycle for added and removed sensors */
+#define DS18B20_REDISCOVERY_MIN_SPARE_MS 200 /* Idle time before the next cycle needed for a search step */
+#define DS18B20_REDISCOVERY_MAX_ADDED 4      /* New sensors collected in one search pass */
+
+#ifndef DS18B20_ALARM_SEARCH_ENABLE
+#define DS18B20_ALARM_SEARCH_ENABLE 0 /* Read only sensors reported by Alarm Search, TH/TL are kept around the last value */
+#endif
+#define DS18B20_ALARM_FULL_READ_CYCLES 12 /* Cycles between two reads of every sensor in alarm search mode */
+
+#define DS18B20_CONVERSION_TIME_MS(resolution) (750 >> (12 - (resolution))) /* Maximum conversion time for resolution */
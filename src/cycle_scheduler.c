@@ -0,0 +1,206 @@
+#include "cycle_scheduler.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "cycle_scheduler.c";
+
+/*
+ * Cycles start on absolute deadlines: deadline(n) = origin + n * period. The delay
+ * to the next start is computed from the clock every time, so the time spent on
+ * conversion, bus traffic and logging does not accumulate. A cycle that ends past
+ * the next deadline skips the missed periods instead of running them back to back.
+ */
+static int64_t period_us                             = 0;
+static int64_t deadline_us                           = 0;
+static int64_t started_us                            = 0;
+static uint8_t stats_ep                              = 0;
+static uint64_t duration_sum_us                      = 0;
+static uint64_t jitter_sum_us                        = 0;
+static uint64_t latency_sum_us                       = 0;
+static cycle_scheduler_stats_t cycle_scheduler_stats = {0};
+
+void cycle_scheduler_add_cluster(esp_zb_cluster_list_t *cluster_list)
+{
+    static const uint16_t attr_ids[] = {
+        CYCLE_SCHEDULER_ATTR_CYCLES_ID,
+        CYCLE_SCHEDULER_ATTR_OVERRUNS_ID,
+        CYCLE_SCHEDULER_ATTR_DURATION_MIN_ID,
+        CYCLE_SCHEDULER_ATTR_DURATION_AVG_ID,
+        CYCLE_SCHEDULER_ATTR_DURATION_MAX_ID,
+        CYCLE_SCHEDULER_ATTR_JITTER_AVG_ID,
+        CYCLE_SCHEDULER_ATTR_JITTER_MAX_ID,
+        CYCLE_SCHEDULER_ATTR_JOINED_ID,
+        CYCLE_SCHEDULER_ATTR_FIRST_REPORT_ID,
+        CYCLE_SCHEDULER_ATTR_DEMANDS_ID,
+        CYCLE_SCHEDULER_ATTR_COALESCED_ID,
+        CYCLE_SCHEDULER_ATTR_LATENCY_AVG_ID,
+        CYCLE_SCHEDULER_ATTR_LATENCY_MAX_ID,
+    };
+    uint32_t zero = 0;
+
+    esp_zb_attribute_list_t *attr_list = esp_zb_zcl_attr_list_create(CYCLE_SCHEDULER_CLUSTER_ID);
+    for (uint8_t i = 0; i < sizeof(attr_ids) / sizeof(attr_ids[0]); i++)
+    {
+        esp_zb_custom_cluster_add_custom_attr(attr_list, attr_ids[i], ESP_ZB_ZCL_ATTR_TYPE_U32, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &zero);
+    }
+    esp_zb_cluster_list_add_custom_cluster(cluster_list, attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+/* Returns the delay in ms until the first cycle should start */
+uint32_t cycle_scheduler_start(uint32_t period_ms, uint8_t ep)
+{
+    period_us   = (int64_t)period_ms * 1000;
+    deadline_us = esp_timer_get_time() + period_us;
+    stats_ep    = ep;
+
+    return period_ms;
+}
+
+/* Moves the next deadline to one new period after the current one started, returns the delay in ms until then */
+uint32_t cycle_scheduler_set_period(uint32_t period_ms)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    deadline_us += (int64_t)period_ms * 1000 - period_us;
+    period_us = (int64_t)period_ms * 1000;
+    if (deadline_us < now_us)
+    {
+        deadline_us = now_us;
+    }
+
+    return (deadline_us - now_us + 999) / 1000;
+}
+
+/* Restarts the deadlines from now so the cycle started for the join is on time, and the ones after it follow it */
+void cycle_scheduler_joined(void)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    deadline_us = now_us;
+    if (cycle_scheduler_stats.joined_ms == 0)
+    {
+        /* esp_timer counts from boot */
+        cycle_scheduler_stats.joined_ms = now_us / 1000;
+        ESP_LOGI(TAG, "Joined %lu ms after boot", cycle_scheduler_stats.joined_ms);
+    }
+}
+
+void cycle_scheduler_reported(void)
+{
+    if (cycle_scheduler_stats.first_report_ms == 0)
+    {
+        cycle_scheduler_stats.first_report_ms = esp_timer_get_time() / 1000;
+        ESP_LOGI(TAG, "First report %lu ms after boot", cycle_scheduler_stats.first_report_ms);
+    }
+}
+
+/* Delay in ms until the next deadline, 0 when it has passed. Used to resume after an on-demand measurement. */
+uint32_t cycle_scheduler_next_delay(void)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    return deadline_us > now_us ? (deadline_us - now_us + 999) / 1000 : 0;
+}
+
+void cycle_scheduler_demand_coalesced(void) { cycle_scheduler_stats.coalesced++; }
+
+void cycle_scheduler_cycle_started(void)
+{
+    started_us = esp_timer_get_time();
+
+    uint32_t jitter_us = started_us > deadline_us ? started_us - deadline_us : 0;
+    if (jitter_us > cycle_scheduler_stats.jitter_max_us)
+    {
+        cycle_scheduler_stats.jitter_max_us = jitter_us;
+    }
+    jitter_sum_us += jitter_us;
+}
+
+/* Only the attributes whose value changed since they were last written, the table starts zeroed */
+static void cycle_scheduler_publish(void)
+{
+    static cycle_scheduler_stats_t published = {0};
+    const struct
+    {
+        uint16_t id;
+        uint32_t *value;
+        uint32_t *published;
+    } attrs[] = {
+        {CYCLE_SCHEDULER_ATTR_CYCLES_ID, &cycle_scheduler_stats.cycles, &published.cycles},
+        {CYCLE_SCHEDULER_ATTR_OVERRUNS_ID, &cycle_scheduler_stats.overruns, &published.overruns},
+        {CYCLE_SCHEDULER_ATTR_DURATION_MIN_ID, &cycle_scheduler_stats.duration_min_us, &published.duration_min_us},
+        {CYCLE_SCHEDULER_ATTR_DURATION_AVG_ID, &cycle_scheduler_stats.duration_avg_us, &published.duration_avg_us},
+        {CYCLE_SCHEDULER_ATTR_DURATION_MAX_ID, &cycle_scheduler_stats.duration_max_us, &published.duration_max_us},
+        {CYCLE_SCHEDULER_ATTR_JITTER_AVG_ID, &cycle_scheduler_stats.jitter_avg_us, &published.jitter_avg_us},
+        {CYCLE_SCHEDULER_ATTR_JITTER_MAX_ID, &cycle_scheduler_stats.jitter_max_us, &published.jitter_max_us},
+        {CYCLE_SCHEDULER_ATTR_JOINED_ID, &cycle_scheduler_stats.joined_ms, &published.joined_ms},
+        {CYCLE_SCHEDULER_ATTR_FIRST_REPORT_ID, &cycle_scheduler_stats.first_report_ms, &published.first_report_ms},
+        {CYCLE_SCHEDULER_ATTR_DEMANDS_ID, &cycle_scheduler_stats.demands, &published.demands},
+        {CYCLE_SCHEDULER_ATTR_COALESCED_ID, &cycle_scheduler_stats.coalesced, &published.coalesced},
+        {CYCLE_SCHEDULER_ATTR_LATENCY_AVG_ID, &cycle_scheduler_stats.latency_avg_us, &published.latency_avg_us},
+        {CYCLE_SCHEDULER_ATTR_LATENCY_MAX_ID, &cycle_scheduler_stats.latency_max_us, &published.latency_max_us},
+    };
+
+    for (uint8_t i = 0; i < sizeof(attrs) / sizeof(attrs[0]); i++)
+    {
+        if (*attrs[i].value == *attrs[i].published)
+        {
+            continue;
+        }
+        esp_zb_zcl_set_attribute_val(stats_ep, CYCLE_SCHEDULER_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attrs[i].id, attrs[i].value, false);
+        *attrs[i].published = *attrs[i].value;
+    }
+}
+
+void cycle_scheduler_demand_answered(int64_t triggered_us)
+{
+    uint32_t latency_us = esp_timer_get_time() - triggered_us;
+
+    cycle_scheduler_stats.demands++;
+    if (latency_us > cycle_scheduler_stats.latency_max_us)
+    {
+        cycle_scheduler_stats.latency_max_us = latency_us;
+    }
+    latency_sum_us += latency_us;
+    cycle_scheduler_stats.latency_avg_us = latency_sum_us / cycle_scheduler_stats.demands;
+    ESP_LOGI(TAG, "On-demand measurement reported %lu us after the trigger", latency_us);
+
+    cycle_scheduler_publish();
+}
+
+/* Returns the delay in ms until the next cycle should start */
+uint32_t cycle_scheduler_cycle_finished(void)
+{
+    int64_t now_us       = esp_timer_get_time();
+    uint32_t duration_us = now_us - started_us;
+
+    cycle_scheduler_stats.cycles++;
+    if (cycle_scheduler_stats.cycles == 1 || duration_us < cycle_scheduler_stats.duration_min_us)
+    {
+        cycle_scheduler_stats.duration_min_us = duration_us;
+    }
+    if (duration_us > cycle_scheduler_stats.duration_max_us)
+    {
+        cycle_scheduler_stats.duration_max_us = duration_us;
+    }
+    duration_sum_us += duration_us;
+    cycle_scheduler_stats.duration_avg_us = duration_sum_us / cycle_scheduler_stats.cycles;
+    cycle_scheduler_stats.jitter_avg_us   = jitter_sum_us / cycle_scheduler_stats.cycles;
+
+    deadline_us += period_us;
+    if (now_us >= deadline_us)
+    {
+        uint32_t skipped = (now_us - deadline_us) / period_us + 1;
+        deadline_us += skipped * period_us;
+        cycle_scheduler_stats.overruns += skipped;
+        ESP_LOGW(TAG, "Cycle took %lu us, skipping %lu period(s)", duration_us, skipped);
+    }
+
+    cycle_scheduler_publish();
+
+    /* Round up so the next cycle never starts before its deadline */
+    return (deadline_us - now_us + 999) / 1000;
+}
+
+const cycle_scheduler_stats_t *cycle_scheduler_get_stats(void) { return &cycle_scheduler_stats; }
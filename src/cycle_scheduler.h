@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define CYCLE_SCHEDULER_CLUSTER_ID 0xFC02            /* Manufacturer-specific cluster with measurement cycle timing */
+#define CYCLE_SCHEDULER_ATTR_CYCLES_ID 0x0000        /* U32: completed cycles */
+#define CYCLE_SCHEDULER_ATTR_OVERRUNS_ID 0x0001      /* U32: periods skipped because a cycle ran past its deadline */
+#define CYCLE_SCHEDULER_ATTR_DURATION_MIN_ID 0x0002  /* U32: shortest cycle, us */
+#define CYCLE_SCHEDULER_ATTR_DURATION_AVG_ID 0x0003  /* U32: average cycle, us */
+#define CYCLE_SCHEDULER_ATTR_DURATION_MAX_ID 0x0004  /* U32: longest cycle, us */
+#define CYCLE_SCHEDULER_ATTR_JITTER_AVG_ID 0x0005    /* U32: average start delay after the deadline, us */
+#define CYCLE_SCHEDULER_ATTR_JITTER_MAX_ID 0x0006    /* U32: longest start delay after the deadline, us */
+#define CYCLE_SCHEDULER_ATTR_JOINED_ID 0x0007        /* U32: boot to network joined, ms, 0 until joined */
+#define CYCLE_SCHEDULER_ATTR_FIRST_REPORT_ID 0x0008  /* U32: boot to the first report after joining, ms, 0 until sent */
+#define CYCLE_SCHEDULER_ATTR_DEMANDS_ID 0x0009       /* U32: answered on-demand measurements */
+#define CYCLE_SCHEDULER_ATTR_COALESCED_ID 0x000A     /* U32: triggers that joined a pending measurement */
+#define CYCLE_SCHEDULER_ATTR_LATENCY_AVG_ID 0x000B   /* U32: average trigger to report, us */
+#define CYCLE_SCHEDULER_ATTR_LATENCY_MAX_ID 0x000C   /* U32: longest trigger to report, us */
+
+    typedef struct
+    {
+        uint32_t cycles;          /* Completed cycles */
+        uint32_t overruns;        /* Skipped periods */
+        uint32_t duration_min_us; /* Cycle start to cycle end */
+        uint32_t duration_avg_us;
+        uint32_t duration_max_us;
+        uint32_t jitter_avg_us; /* Cycle start relative to its deadline */
+        uint32_t jitter_max_us;
+        uint32_t joined_ms; /* Boot to the first network join */
+        uint32_t first_report_ms;
+        uint32_t demands; /* On-demand measurements answered */
+        uint32_t coalesced;
+        uint32_t latency_avg_us; /* Trigger to report */
+        uint32_t latency_max_us;
+    } cycle_scheduler_stats_t;
+
+    void cycle_scheduler_add_cluster(esp_zb_cluster_list_t *cluster_list);
+    uint32_t cycle_scheduler_start(uint32_t period_ms, uint8_t ep);
+    uint32_t cycle_scheduler_set_period(uint32_t period_ms);
+    void cycle_scheduler_joined(void);
+    void cycle_scheduler_reported(void);
+    uint32_t cycle_scheduler_next_delay(void);
+    void cycle_scheduler_demand_coalesced(void);
+    void cycle_scheduler_demand_answered(int64_t triggered_us);
+    void cycle_scheduler_cycle_started(void);
+    uint32_t cycle_scheduler_cycle_finished(void);
+    const cycle_scheduler_stats_t *cycle_scheduler_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
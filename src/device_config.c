@@ -0,0 +1,151 @@
+#include "device_config.h"
+
+#include <string.h>
+
+#include "config.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "device_config.c";
+
+#define DEVICE_CONFIG_NAMESPACE "thermometer"
+#define DEVICE_CONFIG_KEY "device"
+
+static device_config_t device_config = {
+    .update_interval   = DS18B20_UPDATE_INTERVAL,
+    .reportable_change = DS18B20_REPORTABLE_CHANGE,
+    .failure_attempts  = DS18B20_READ_FAILURE_ATTEMPTS,
+    .resolution        = DS18B20_RESOLUTION,
+};
+
+static bool device_config_valid(uint16_t attr_id, const device_config_t *config)
+{
+    switch (attr_id)
+    {
+        case DEVICE_CONFIG_ATTR_UPDATE_INTERVAL_ID:
+            return config->update_interval >= DEVICE_CONFIG_UPDATE_INTERVAL_MIN && config->update_interval <= DEVICE_CONFIG_UPDATE_INTERVAL_MAX;
+        case DEVICE_CONFIG_ATTR_REPORTABLE_CHANGE_ID:
+            return config->reportable_change > 0;
+        case DEVICE_CONFIG_ATTR_FAILURE_ATTEMPTS_ID:
+            return config->failure_attempts <= DEVICE_CONFIG_FAILURE_ATTEMPTS_MAX;
+        case DEVICE_CONFIG_ATTR_RESOLUTION_ID:
+            return config->resolution >= 9 && config->resolution <= 12;
+        default:
+            return false;
+    }
+}
+
+void device_config_load(void)
+{
+    static const uint16_t attr_ids[] = {
+        DEVICE_CONFIG_ATTR_UPDATE_INTERVAL_ID,
+        DEVICE_CONFIG_ATTR_REPORTABLE_CHANGE_ID,
+        DEVICE_CONFIG_ATTR_FAILURE_ATTEMPTS_ID,
+        DEVICE_CONFIG_ATTR_RESOLUTION_ID,
+    };
+    nvs_handle_t handle;
+
+    if (nvs_open(DEVICE_CONFIG_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        return;
+    }
+
+    /* A shorter record written by an older firmware only overrides the leading fields */
+    device_config_t stored = device_config;
+    size_t size            = sizeof(stored);
+    esp_err_t err          = nvs_get_blob(handle, DEVICE_CONFIG_KEY, &stored, &size);
+    nvs_close(handle);
+    if (err != ESP_OK)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < sizeof(attr_ids) / sizeof(attr_ids[0]); i++)
+    {
+        if (!device_config_valid(attr_ids[i], &stored))
+        {
+            ESP_LOGW(TAG, "Invalid stored device configuration, using defaults");
+            return;
+        }
+    }
+    device_config = stored;
+
+    ESP_LOGI(
+        TAG,
+        "Update interval %lu ms, reportable change %u, failure attempts %u, resolution %u",
+        device_config.update_interval,
+        device_config.reportable_change,
+        device_config.failure_attempts,
+        device_config.resolution);
+}
+
+const device_config_t *device_config_get(void) { return &device_config; }
+
+void device_config_add_cluster(esp_zb_cluster_list_t *cluster_list)
+{
+    device_config_t config = device_config;
+
+    esp_zb_attribute_list_t *attr_list = esp_zb_zcl_attr_list_create(DEVICE_CONFIG_CLUSTER_ID);
+    esp_zb_custom_cluster_add_custom_attr(
+        attr_list, DEVICE_CONFIG_ATTR_UPDATE_INTERVAL_ID, ESP_ZB_ZCL_ATTR_TYPE_U32, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &config.update_interval);
+    esp_zb_custom_cluster_add_custom_attr(
+        attr_list, DEVICE_CONFIG_ATTR_REPORTABLE_CHANGE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &config.reportable_change);
+    esp_zb_custom_cluster_add_custom_attr(
+        attr_list, DEVICE_CONFIG_ATTR_FAILURE_ATTEMPTS_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &config.failure_attempts);
+    esp_zb_custom_cluster_add_custom_attr(attr_list, DEVICE_CONFIG_ATTR_RESOLUTION_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &config.resolution);
+    esp_zb_cluster_list_add_custom_cluster(cluster_list, attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+/* Validates and persists one attribute write, a rejected value is replaced by the current one */
+esp_err_t device_config_set(uint8_t ep, uint16_t attr_id, const void *value)
+{
+    device_config_t config = device_config;
+    void *field            = NULL;
+    size_t size            = 0;
+
+    switch (attr_id)
+    {
+        case DEVICE_CONFIG_ATTR_UPDATE_INTERVAL_ID:
+            field = &config.update_interval;
+            size  = sizeof(config.update_interval);
+            break;
+        case DEVICE_CONFIG_ATTR_REPORTABLE_CHANGE_ID:
+            field = &config.reportable_change;
+            size  = sizeof(config.reportable_change);
+            break;
+        case DEVICE_CONFIG_ATTR_FAILURE_ATTEMPTS_ID:
+            field = &config.failure_attempts;
+            size  = sizeof(config.failure_attempts);
+            break;
+        case DEVICE_CONFIG_ATTR_RESOLUTION_ID:
+            field = &config.resolution;
+            size  = sizeof(config.resolution);
+            break;
+        default:
+            return ESP_ERR_NOT_FOUND;
+    }
+
+    memcpy(field, value, size);
+    if (!device_config_valid(attr_id, &config))
+    {
+        /* Put the valid value back, the stack has already stored the rejected one */
+        void *current = (uint8_t *)&device_config + ((uint8_t *)field - (uint8_t *)&config);
+        esp_zb_zcl_set_attribute_val(ep, DEVICE_CONFIG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attr_id, current, false);
+        ESP_LOGW(TAG, "Rejected value for device configuration attribute 0x%04x", attr_id);
+        return ESP_ERR_INVALID_ARG;
+    }
+    device_config = config;
+
+    nvs_handle_t handle;
+    ESP_RETURN_ON_ERROR(nvs_open(DEVICE_CONFIG_NAMESPACE, NVS_READWRITE, &handle), TAG, "Failed to open NVS namespace");
+    esp_err_t ret = nvs_set_blob(handle, DEVICE_CONFIG_KEY, &device_config, sizeof(device_config));
+    if (ret == ESP_OK)
+    {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to write device configuration");
+    return ESP_OK;
+}
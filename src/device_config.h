@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define DEVICE_CONFIG_CLUSTER_ID 0xFC04                /* Manufacturer-specific device-wide configuration cluster */
+#define DEVICE_CONFIG_ATTR_UPDATE_INTERVAL_ID 0x0000   /* uint32: measurement cycle period in ms */
+#define DEVICE_CONFIG_ATTR_REPORTABLE_CHANGE_ID 0x0001 /* uint16: reportable change of every endpoint in 0.01°C */
+#define DEVICE_CONFIG_ATTR_FAILURE_ATTEMPTS_ID 0x0002  /* uint8: failed cycles before a sensor is reported unknown */
+#define DEVICE_CONFIG_ATTR_RESOLUTION_ID 0x0003        /* uint8: resolution of the endpoints not set to another one, 9..12 */
+
+#define DEVICE_CONFIG_UPDATE_INTERVAL_MIN 1000
+#define DEVICE_CONFIG_UPDATE_INTERVAL_MAX 3600000
+#define DEVICE_CONFIG_FAILURE_ATTEMPTS_MAX 30
+
+    /* Persisted, new fields must be appended so older records still load */
+    typedef struct
+    {
+        uint32_t update_interval;
+        uint16_t reportable_change;
+        uint8_t failure_attempts;
+        uint8_t resolution;
+    } device_config_t;
+
+    void device_config_load(void);
+    const device_config_t *device_config_get(void);
+    void device_config_add_cluster(esp_zb_cluster_list_t *cluster_list);
+    esp_err_t device_config_set(uint8_t ep, uint16_t attr_id, const void *value);
+
+#ifdef __cplusplus
+}
+#endif
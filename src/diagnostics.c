@@ -0,0 +1,86 @@
+#include "diagnostics.h"
+
+#include "config.h"
+#include "esp_log.h"
+
+static const char *TAG = "diagnostics.c";
+
+void diagnostics_add_cluster(esp_zb_cluster_list_t *cluster_list, bool bus_time)
+{
+    static const uint16_t counter_ids[] = {
+        DIAGNOSTICS_ATTR_CRC_FAILURES_ID,
+        DIAGNOSTICS_ATTR_DISCONNECTS_ID,
+        DIAGNOSTICS_ATTR_RETRIES_ID,
+        DIAGNOSTICS_ATTR_SET_FAILURES_ID,
+    };
+    uint16_t zero16 = 0;
+    uint32_t zero32 = 0;
+
+    esp_zb_attribute_list_t *attr_list = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS);
+    for (uint8_t i = 0; i < sizeof(counter_ids) / sizeof(counter_ids[0]); i++)
+    {
+        esp_zb_cluster_add_manufacturer_attr(
+            attr_list, ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, counter_ids[i], ZB_MANUFACTURER_CODE, ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &zero16);
+    }
+    if (bus_time)
+    {
+        esp_zb_cluster_add_manufacturer_attr(
+            attr_list, ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, DIAGNOSTICS_ATTR_BUS_TIME_ID, ZB_MANUFACTURER_CODE, ESP_ZB_ZCL_ATTR_TYPE_U32, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &zero32);
+        esp_zb_cluster_add_manufacturer_attr(
+            attr_list, ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, DIAGNOSTICS_ATTR_BUS_SLOTS_ID, ZB_MANUFACTURER_CODE, ESP_ZB_ZCL_ATTR_TYPE_U32, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &zero32);
+    }
+
+    if (esp_zb_cluster_list_add_diagnostics_cluster(cluster_list, attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to add the diagnostics cluster");
+    }
+}
+
+/* The attributes are manufacturer-specific, esp_zb_zcl_set_attribute_val() would not find them */
+static void diagnostics_set(uint8_t ep, uint16_t attr_id, void *value)
+{
+    esp_zb_zcl_status_t status = esp_zb_zcl_set_manufacturer_attribute_val(
+        ep, ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ZB_MANUFACTURER_CODE, attr_id, value, false);
+
+    if (status != ESP_ZB_ZCL_STATUS_SUCCESS)
+    {
+        ESP_LOGW(TAG, "Failed to update diagnostics attribute 0x%04x for endpoint %d, status: %d", attr_id, ep, status);
+    }
+}
+
+/* Counters change only on failures, so they are pushed to the attribute table by the caller when dirty */
+void diagnostics_publish(uint8_t ep, const diagnostics_counters_t *counters)
+{
+    diagnostics_set(ep, DIAGNOSTICS_ATTR_CRC_FAILURES_ID, (void *)&counters->crc_failures);
+    diagnostics_set(ep, DIAGNOSTICS_ATTR_DISCONNECTS_ID, (void *)&counters->disconnects);
+    diagnostics_set(ep, DIAGNOSTICS_ATTR_RETRIES_ID, (void *)&counters->retries);
+    diagnostics_set(ep, DIAGNOSTICS_ATTR_SET_FAILURES_ID, (void *)&counters->set_failures);
+}
+
+void diagnostics_publish_bus_time(uint8_t ep, uint32_t bus_time_us, uint32_t bus_slots)
+{
+    diagnostics_set(ep, DIAGNOSTICS_ATTR_BUS_TIME_ID, &bus_time_us);
+    diagnostics_set(ep, DIAGNOSTICS_ATTR_BUS_SLOTS_ID, &bus_slots);
+}
+
+/* Returns false for attributes that are not resettable counters */
+bool diagnostics_reset(diagnostics_counters_t *counters, uint16_t attr_id)
+{
+    switch (attr_id)
+    {
+        case DIAGNOSTICS_ATTR_CRC_FAILURES_ID:
+            counters->crc_failures = 0;
+            return true;
+        case DIAGNOSTICS_ATTR_DISCONNECTS_ID:
+            counters->disconnects = 0;
+            return true;
+        case DIAGNOSTICS_ATTR_RETRIES_ID:
+            counters->retries = 0;
+            return true;
+        case DIAGNOSTICS_ATTR_SET_FAILURES_ID:
+            counters->set_failures = 0;
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Manufacturer-specific attributes of the Diagnostics cluster (0x0B05), writing any value resets a counter */
+#define DIAGNOSTICS_ATTR_CRC_FAILURES_ID 0x4000 /* U16: scratchpad reads with a bad CRC */
+#define DIAGNOSTICS_ATTR_DISCONNECTS_ID 0x4001  /* U16: reads without a presence pulse or after a power-on reset */
+#define DIAGNOSTICS_ATTR_RETRIES_ID 0x4002      /* U16: in-cycle scratchpad re-reads and re-conversions */
+#define DIAGNOSTICS_ATTR_SET_FAILURES_ID 0x4003 /* U16: failed ZCL attribute updates */
+#define DIAGNOSTICS_ATTR_BUS_TIME_ID 0x4004     /* U32: 1-Wire bus time of the last cycle in us, first endpoint only */
+#define DIAGNOSTICS_ATTR_BUS_SLOTS_ID 0x4005    /* U32: 1-Wire time slots of the last cycle, first endpoint only */
+
+    typedef struct
+    {
+        uint16_t crc_failures;
+        uint16_t disconnects;
+        uint16_t retries;
+        uint16_t set_failures;
+    } diagnostics_counters_t;
+
+    void diagnostics_add_cluster(esp_zb_cluster_list_t *cluster_list, bool bus_time);
+    void diagnostics_publish(uint8_t ep, const diagnostics_counters_t *counters);
+    void diagnostics_publish_bus_time(uint8_t ep, uint32_t bus_time_us, uint32_t bus_slots);
+    bool diagnostics_reset(diagnostics_counters_t *counters, uint16_t attr_id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,167 @@
+#include "event_log.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "main.h"
+
+static const char *TAG = "event_log.c";
+
+_Static_assert((EVENT_LOG_SIZE & (EVENT_LOG_SIZE - 1)) == 0, "EVENT_LOG_SIZE must be a power of two");
+
+typedef struct
+{
+    const char *tag; /* Module the event is logged for, so the output reads like the ESP_LOG it replaces */
+    esp_log_level_t level;
+} event_log_format_t;
+
+static const event_log_format_t formats[EVENT_LOG_EVENT_COUNT] = {
+    [EVENT_LOG_TEMPERATURE_UPDATED] = {"thermometer.c", ESP_LOG_INFO},
+    [EVENT_LOG_TEMPERATURE_UNKNOWN] = {"thermometer.c", ESP_LOG_WARN},
+    [EVENT_LOG_ZB_SIGNAL]           = {"main.c", ESP_LOG_INFO},
+    [EVENT_LOG_DEFAULT_RESPONSE]    = {"main.c", ESP_LOG_INFO},
+};
+
+#if EVENT_LOG_ENABLE
+/* Single producer, single consumer: every event is recorded from the Zigbee task and only the formatter task
+   reads them, so the two indexes are enough and the producer never blocks. Indexes run freely and are masked. */
+static event_log_entry_t ring[EVENT_LOG_SIZE];
+static atomic_uint head;
+static atomic_uint tail;
+static atomic_uint dropped;
+static TaskHandle_t formatter_task = NULL;
+#endif
+
+static void event_log_print(const event_log_entry_t *entry)
+{
+    char message[128];
+
+    switch (entry->id)
+    {
+        case EVENT_LOG_TEMPERATURE_UPDATED:
+            /* The sign goes first on its own, -0.50 has no negative whole degrees to carry it */
+            snprintf(
+                message,
+                sizeof(message),
+                "Updated temperature for endpoint %d: %s%i.%02i°C",
+                entry->ep,
+                entry->value < 0 ? "-" : "",
+                (int)(abs(entry->value) / 100),
+                (int)(abs(entry->value) % 100));
+            break;
+        case EVENT_LOG_TEMPERATURE_UNKNOWN:
+            snprintf(message, sizeof(message), "Setting temperature to unknown for endpoint %d", entry->ep);
+            break;
+        case EVENT_LOG_ZB_SIGNAL:
+            snprintf(message, sizeof(message), "signal type received: %s", signal_type_to_string((esp_zb_app_signal_type_t)entry->arg));
+            break;
+        case EVENT_LOG_DEFAULT_RESPONSE:
+            snprintf(
+                message,
+                sizeof(message),
+                "Received default response: endpoint(%d), cluster(0x%x), command(0x%x), status(0x%x)",
+                entry->ep,
+                entry->arg,
+                (unsigned)(entry->value >> 8) & 0xFF,
+                (unsigned)entry->value & 0xFF);
+            break;
+        default:
+            ESP_LOGW(TAG, "Unknown event %d", entry->id);
+            return;
+    }
+
+#if EVENT_LOG_ENABLE
+    /* The time the event happened, not the time it got formatted */
+    static const char letters[] = {'N', 'E', 'W', 'I', 'D', 'V'};
+    esp_log_write(formats[entry->id].level, formats[entry->id].tag, "%c (%lu) %s: %s\n", letters[formats[entry->id].level], entry->timestamp_ms, formats[entry->id].tag, message);
+#else
+    ESP_LOG_LEVEL(formats[entry->id].level, formats[entry->id].tag, "%s", message);
+#endif
+
+    if (entry->id == EVENT_LOG_DEFAULT_RESPONSE && (entry->value & 0xFF) != ESP_ZB_ZCL_STATUS_SUCCESS)
+    {
+        ESP_LOGW(formats[entry->id].tag, "Default response indicates error status: 0x%x", (unsigned)entry->value & 0xFF);
+    }
+}
+
+#if EVENT_LOG_ENABLE
+static void event_log_task(void *arg)
+{
+    uint32_t reported_dropped = 0;
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        unsigned t = atomic_load_explicit(&tail, memory_order_relaxed);
+        while (t != atomic_load_explicit(&head, memory_order_acquire))
+        {
+            event_log_entry_t entry = ring[t & (EVENT_LOG_SIZE - 1)];
+            atomic_store_explicit(&tail, ++t, memory_order_release);
+            event_log_print(&entry);
+        }
+
+        uint32_t now_dropped = event_log_dropped();
+        if (now_dropped != reported_dropped)
+        {
+            ESP_LOGW(TAG, "%lu event records dropped, the formatter task could not keep up", now_dropped - reported_dropped);
+            reported_dropped = now_dropped;
+        }
+    }
+}
+#endif
+
+esp_err_t event_log_init(void)
+{
+#if EVENT_LOG_ENABLE
+    /* Lowest priority above idle, records are only formatted while nothing else has work to do */
+    ESP_RETURN_ON_FALSE(xTaskCreate(event_log_task, "event_log", 3072, NULL, 1, &formatter_task) == pdPASS, ESP_ERR_NO_MEM, TAG, "create event log task failed");
+#endif
+    return ESP_OK;
+}
+
+/* Hot-path replacement for ESP_LOG: copies 12 bytes and wakes the formatter, or logs right away when
+   EVENT_LOG_ENABLE is off. Must only be called from the Zigbee task. */
+void event_log_record(event_log_id_t id, uint8_t ep, uint16_t arg, int32_t value)
+{
+    event_log_entry_t entry = {
+        .timestamp_ms = esp_log_timestamp(),
+        .id           = id,
+        .ep           = ep,
+        .arg          = arg,
+        .value        = value,
+    };
+
+#if EVENT_LOG_ENABLE
+    unsigned h = atomic_load_explicit(&head, memory_order_relaxed);
+    if (h - atomic_load_explicit(&tail, memory_order_acquire) >= EVENT_LOG_SIZE)
+    {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+    ring[h & (EVENT_LOG_SIZE - 1)] = entry;
+    atomic_store_explicit(&head, h + 1, memory_order_release);
+
+    if (formatter_task != NULL)
+    {
+        xTaskNotifyGive(formatter_task);
+    }
+#else
+    event_log_print(&entry);
+#endif
+}
+
+uint32_t event_log_dropped(void)
+{
+#if EVENT_LOG_ENABLE
+    return atomic_load_explicit(&dropped, memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
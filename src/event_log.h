@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define EVENT_LOG_SIZE 256 /* Records buffered for the formatter task, a power of two: one cycle of all 240 endpoints fits */
+
+    typedef enum
+    {
+        EVENT_LOG_TEMPERATURE_UPDATED, /* ep, value: temperature in 0.01°C */
+        EVENT_LOG_TEMPERATURE_UNKNOWN, /* ep */
+        EVENT_LOG_ZB_SIGNAL,           /* arg: signal type, value: error status */
+        EVENT_LOG_DEFAULT_RESPONSE,    /* ep, arg: cluster, value: command << 8 | status */
+        EVENT_LOG_EVENT_COUNT,
+    } event_log_id_t;
+
+    /* Fixed-size record, 12 bytes */
+    typedef struct
+    {
+        uint32_t timestamp_ms; /* esp_log_timestamp() when the event happened */
+        uint8_t id;            /* event_log_id_t */
+        uint8_t ep;
+        uint16_t arg;
+        int32_t value;
+    } event_log_entry_t;
+
+    esp_err_t event_log_init(void);
+    void event_log_record(event_log_id_t id, uint8_t ep, uint16_t arg, int32_t value);
+    uint32_t event_log_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,470 @@
+#include "history.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "config.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "rom_map.h"
+
+static const char *TAG = "history.c";
+
+/*
+ * The partition is a ring of erase-sized blocks written strictly in order, so every
+ * block is erased once per pass over the ring. A block starts with a header and is
+ * followed by records until the first erased byte:
+ *   [0]    record length, excluding this byte (0xFF is erased flash)
+ *   [1]    flags, bit 0 set when the values are absolute instead of deltas
+ *   [2..]  time since the previous record of the block (or the block start) in seconds, varint
+ *          entries: endpoint, then the zigzag varint value (absolute or delta to the last
+ *          value of that endpoint in the block)
+ * Only changed readings are stored. The first record of a block and the first record
+ * after boot are absolute, so every block decodes on its own.
+ */
+#define HISTORY_PARTITION_SUBTYPE 0x40
+#define HISTORY_BLOCK_SIZE 4096
+#define HISTORY_BLOCK_MAGIC 0x31545348 /* "HST1" */
+#define HISTORY_RECORD_MAX 254         /* Length byte included, so the length never reads as erased flash */
+#define HISTORY_RECORD_FLAG_ABSOLUTE 0x01
+#define HISTORY_ENTRY_MAX_SIZE 4       /* endpoint + zigzag varint of a 16-bit difference */
+#define HISTORY_WRITE_BUFFER_SIZE 256
+#define HISTORY_FETCH_SAMPLES 10       /* Samples per frame, keeps a frame within one unfragmented APS payload */
+#define HISTORY_FETCH_INTERVAL_MS 100  /* Pause between two frames of a fetch */
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t start_time;
+} history_block_header_t;
+
+typedef struct
+{
+    bool active;
+    uint8_t ep;
+    uint32_t from;
+    uint32_t to;
+    uint16_t dst_addr;
+    uint8_t dst_ep;
+    uint16_t block;
+    uint16_t blocks_left;
+    uint32_t offset; /* Within the block, 0 before the header was read */
+    uint32_t time;
+    int16_t value;
+    int64_t started_us;
+} history_fetch_t;
+
+static const esp_partition_t *partition          = NULL;
+static uint16_t block_count                      = 0;
+static uint16_t block                            = 0; /* Block being written */
+static uint32_t block_seq                        = 0;
+static uint32_t write_offset                     = 0; /* Flushed bytes of the block being written */
+static uint32_t last_time                        = 0; /* Time of the last record in the block being written */
+static uint32_t time_base                        = 0;
+static bool absolute_pending                     = true;
+static uint8_t history_ep                        = 0;
+static uint8_t buffer[HISTORY_WRITE_BUFFER_SIZE] = {0};
+static uint16_t buffered                         = 0;
+static int16_t current[ROM_MAP_MAX_SLOTS]        = {0};
+static int16_t stored[ROM_MAP_MAX_SLOTS]         = {0};
+static bool present[ROM_MAP_MAX_SLOTS]           = {0};
+static history_fetch_t fetch                     = {0};
+static history_stats_t history_stats             = {0};
+
+static uint8_t varint_encode(uint32_t value, uint8_t *out)
+{
+    uint8_t size = 0;
+
+    do
+    {
+        out[size] = value & 0x7F;
+        value >>= 7;
+        if (value)
+        {
+            out[size] |= 0x80;
+        }
+        size++;
+    } while (value);
+
+    return size;
+}
+
+static uint8_t varint_decode(const uint8_t *in, uint8_t size, uint32_t *value)
+{
+    uint8_t read = 0;
+
+    *value = 0;
+    while (read < size && read < 5)
+    {
+        *value |= (uint32_t)(in[read] & 0x7F) << (7 * read);
+        if (!(in[read++] & 0x80))
+        {
+            return read;
+        }
+    }
+    return 0;
+}
+
+static uint8_t zigzag_encode(int32_t value, uint8_t *out) { return varint_encode(((uint32_t)value << 1) ^ (uint32_t)(value >> 31), out); }
+
+static uint8_t zigzag_decode(const uint8_t *in, uint8_t size, int32_t *value)
+{
+    uint32_t zigzag;
+    uint8_t read = varint_decode(in, size, &zigzag);
+
+    *value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+    return read;
+}
+
+static uint32_t history_time(void) { return time_base + esp_timer_get_time() / 1000000; }
+
+void history_flush(void)
+{
+    if (partition == NULL || buffered == 0)
+    {
+        return;
+    }
+
+    esp_err_t err = esp_partition_write(partition, block * HISTORY_BLOCK_SIZE + write_offset, buffer, buffered);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to write history: %s", esp_err_to_name(err));
+    }
+    write_offset += buffered;
+    history_stats.flash_bytes += buffered;
+    buffered = 0;
+}
+
+static void history_start_block(uint32_t now)
+{
+    history_block_header_t header = {
+        .magic      = HISTORY_BLOCK_MAGIC,
+        .seq        = ++block_seq,
+        .start_time = now,
+    };
+
+    block = (block + 1) % block_count;
+    history_stats.erases++;
+    if (esp_partition_erase_range(partition, block * HISTORY_BLOCK_SIZE, HISTORY_BLOCK_SIZE) != ESP_OK ||
+        esp_partition_write(partition, block * HISTORY_BLOCK_SIZE, &header, sizeof(header)) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to start history block %d", block);
+    }
+
+    history_stats.flash_bytes += sizeof(header);
+    write_offset     = sizeof(header);
+    last_time        = now;
+    absolute_pending = true;
+}
+
+/* Walks the records of the newest block to find where writing continues */
+static void history_resume_block(const history_block_header_t *header)
+{
+    uint8_t record[HISTORY_RECORD_MAX];
+
+    block_seq    = header->seq;
+    last_time    = header->start_time;
+    write_offset = sizeof(history_block_header_t);
+
+    while (write_offset < HISTORY_BLOCK_SIZE)
+    {
+        uint8_t length;
+        uint32_t dt;
+
+        esp_partition_read(partition, block * HISTORY_BLOCK_SIZE + write_offset, &length, 1);
+        if (length == 0xFF || write_offset + 1 + length > HISTORY_BLOCK_SIZE)
+        {
+            break;
+        }
+        esp_partition_read(partition, block * HISTORY_BLOCK_SIZE + write_offset + 1, record, length);
+        if (length > 1 && varint_decode(&record[1], length - 1, &dt) > 0)
+        {
+            last_time += dt;
+        }
+        write_offset += 1 + length;
+    }
+}
+
+void history_init(void)
+{
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, HISTORY_PARTITION_SUBTYPE, "history");
+    if (partition == NULL)
+    {
+        ESP_LOGW(TAG, "No history partition, readings are not kept");
+        return;
+    }
+    block_count = partition->size / HISTORY_BLOCK_SIZE;
+
+    history_block_header_t newest = {0};
+    for (uint16_t i = 0; i < block_count; i++)
+    {
+        history_block_header_t header;
+        if (esp_partition_read(partition, i * HISTORY_BLOCK_SIZE, &header, sizeof(header)) == ESP_OK && header.magic == HISTORY_BLOCK_MAGIC &&
+            header.seq > newest.seq)
+        {
+            newest = header;
+            block  = i;
+        }
+    }
+
+    if (newest.seq == 0)
+    {
+        block = block_count - 1;
+        history_start_block(0);
+    }
+    else
+    {
+        history_resume_block(&newest);
+    }
+
+    /* Time does not advance while the device is off, the history continues from its last record */
+    time_base        = last_time;
+    absolute_pending = true;
+
+    ESP_LOGI(TAG, "History of %d blocks, writing block %d at offset %lu, time %lu s", block_count, block, write_offset, time_base);
+}
+
+void history_add_cluster(esp_zb_cluster_list_t *cluster_list, uint8_t ep)
+{
+    uint32_t time = history_time();
+
+    history_ep                         = ep;
+    esp_zb_attribute_list_t *attr_list = esp_zb_zcl_attr_list_create(HISTORY_CLUSTER_ID);
+    esp_zb_custom_cluster_add_custom_attr(attr_list, HISTORY_ATTR_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_U32, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &time);
+    esp_zb_cluster_list_add_custom_cluster(cluster_list, attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+void history_add(uint8_t ep, int16_t value)
+{
+    uint8_t slot = ep - DS18B20_FIRST_ENDPOINT;
+
+    current[slot] = value;
+    present[slot] = true;
+}
+
+static void history_buffer(const uint8_t *record, uint8_t size)
+{
+    if (buffered + size > sizeof(buffer))
+    {
+        history_flush();
+    }
+    memcpy(&buffer[buffered], record, size);
+    buffered += size;
+    history_stats.encoded_bytes += size;
+}
+
+void history_commit(void)
+{
+    if (partition == NULL)
+    {
+        return;
+    }
+
+    uint32_t now  = history_time();
+    uint16_t slot = 0;
+
+    while (slot < ROM_MAP_MAX_SLOTS)
+    {
+        if (write_offset + buffered + HISTORY_RECORD_MAX > HISTORY_BLOCK_SIZE)
+        {
+            history_flush();
+            history_start_block(now);
+            slot = 0; /* The new block opens with absolute values of every sensor */
+        }
+
+        uint8_t record[HISTORY_RECORD_MAX];
+        uint8_t size    = 2;
+        uint8_t entries = 0;
+
+        record[1] = absolute_pending ? HISTORY_RECORD_FLAG_ABSOLUTE : 0;
+        size += varint_encode(now - last_time, &record[size]);
+
+        for (; slot < ROM_MAP_MAX_SLOTS && size + HISTORY_ENTRY_MAX_SIZE <= HISTORY_RECORD_MAX; slot++)
+        {
+            if (!present[slot] || (!absolute_pending && current[slot] == stored[slot]))
+            {
+                continue;
+            }
+
+            record[size++] = slot + DS18B20_FIRST_ENDPOINT;
+            size += zigzag_encode(absolute_pending ? current[slot] : current[slot] - stored[slot], &record[size]);
+            stored[slot] = current[slot];
+            entries++;
+        }
+
+        if (entries == 0)
+        {
+            break;
+        }
+
+        record[0] = size - 1;
+        history_buffer(record, size);
+        last_time = now;
+        history_stats.samples += entries;
+        history_stats.raw_bytes += entries * (sizeof(uint32_t) + sizeof(uint8_t) + sizeof(int16_t));
+    }
+    absolute_pending = false;
+
+    esp_zb_zcl_set_attribute_val(history_ep, HISTORY_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, HISTORY_ATTR_TIME_ID, &now, false);
+}
+
+/* An endpoint appears at most once per record, so a record adds at most one sample to the frame */
+static uint8_t history_fetch_record(const uint8_t *record, uint8_t length, uint8_t *frame, uint8_t count)
+{
+    uint8_t pos = 1;
+    uint32_t dt;
+    uint8_t read = varint_decode(&record[pos], length - pos, &dt);
+
+    if (read == 0)
+    {
+        return count;
+    }
+    pos += read;
+    fetch.time += dt;
+
+    while (pos < length)
+    {
+        uint8_t ep = record[pos++];
+        int32_t value;
+
+        read = zigzag_decode(&record[pos], length - pos, &value);
+        if (read == 0)
+        {
+            break;
+        }
+        pos += read;
+
+        if (ep != fetch.ep)
+        {
+            continue;
+        }
+
+        fetch.value = (record[0] & HISTORY_RECORD_FLAG_ABSOLUTE) ? value : fetch.value + value;
+        if (fetch.time >= fetch.from && fetch.time <= fetch.to)
+        {
+            uint8_t *sample = &frame[2 + count * 6];
+            memcpy(sample, &fetch.time, sizeof(uint32_t));
+            memcpy(sample + 4, &fetch.value, sizeof(int16_t));
+            count++;
+        }
+    }
+    return count;
+}
+
+static void history_fetch_next_block(void)
+{
+    fetch.block  = (fetch.block + 1) % block_count;
+    fetch.offset = 0;
+    fetch.blocks_left--;
+}
+
+static void history_fetch_step(uint8_t param)
+{
+    uint8_t frame[2 + HISTORY_FETCH_SAMPLES * 6 + 1];
+    uint8_t *payload = &frame[1]; /* Octet string, the first byte is the length */
+    uint8_t count    = 0;
+
+    while (count < HISTORY_FETCH_SAMPLES && fetch.blocks_left > 0)
+    {
+        uint32_t address = fetch.block * HISTORY_BLOCK_SIZE;
+
+        if (fetch.offset == 0)
+        {
+            history_block_header_t header;
+            esp_partition_read(partition, address, &header, sizeof(header));
+            if (header.magic != HISTORY_BLOCK_MAGIC)
+            {
+                history_fetch_next_block();
+                continue;
+            }
+            fetch.time   = header.start_time;
+            fetch.offset = sizeof(header);
+        }
+
+        uint8_t length = 0xFF;
+        if (fetch.offset < HISTORY_BLOCK_SIZE)
+        {
+            esp_partition_read(partition, address + fetch.offset, &length, 1);
+        }
+        if (length == 0xFF || fetch.offset + 1 + length > HISTORY_BLOCK_SIZE)
+        {
+            history_fetch_next_block();
+            continue;
+        }
+
+        uint8_t record[HISTORY_RECORD_MAX];
+        esp_partition_read(partition, address + fetch.offset + 1, record, length);
+
+        count = history_fetch_record(record, length, payload, count);
+        fetch.offset += 1 + length;
+    }
+
+    payload[0] = fetch.ep;
+    payload[1] = count;
+    frame[0]   = 2 + count * 6;
+
+    esp_zb_zcl_custom_cluster_cmd_req_t req = {
+        .zcl_basic_cmd.dst_addr_u.addr_short = fetch.dst_addr,
+        .zcl_basic_cmd.dst_endpoint          = fetch.dst_ep,
+        .zcl_basic_cmd.src_endpoint          = history_ep,
+        .address_mode                        = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+        .profile_id                          = ESP_ZB_AF_HA_PROFILE_ID,
+        .cluster_id                          = HISTORY_CLUSTER_ID,
+        .direction                           = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
+        .custom_cmd_id                       = HISTORY_CMD_SAMPLES_ID,
+        .data.type                           = ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+        .data.size                           = frame[0] + 1,
+        .data.value                          = frame,
+    };
+    esp_zb_zcl_custom_cluster_cmd_req(&req);
+
+    history_stats.fetch_frames++;
+    history_stats.fetch_samples += count;
+
+    if (count == 0)
+    {
+        fetch.active                = false;
+        history_stats.fetch_time_us = esp_timer_get_time() - fetch.started_us;
+        ESP_LOGI(TAG, "History fetch for endpoint %d done in %lu us", fetch.ep, history_stats.fetch_time_us);
+        return;
+    }
+    esp_zb_scheduler_alarm(history_fetch_step, 0, HISTORY_FETCH_INTERVAL_MS);
+}
+
+esp_err_t history_handle_command(const esp_zb_zcl_custom_cluster_command_message_t *message)
+{
+    const uint8_t *payload = message->data.value;
+
+    ESP_RETURN_ON_FALSE(partition, ESP_ERR_NOT_SUPPORTED, TAG, "No history partition");
+    ESP_RETURN_ON_FALSE(message->info.command.id == HISTORY_CMD_FETCH_ID, ESP_ERR_NOT_SUPPORTED, TAG, "Unknown history command 0x%x", message->info.command.id);
+    ESP_RETURN_ON_FALSE(payload && message->data.size >= 9, ESP_ERR_INVALID_ARG, TAG, "Short history fetch request");
+    ESP_RETURN_ON_FALSE(!fetch.active, ESP_ERR_INVALID_STATE, TAG, "History fetch already running");
+    ESP_RETURN_ON_FALSE(
+        message->info.src_address.addr_type == ESP_ZB_ZCL_ADDR_TYPE_SHORT, ESP_ERR_NOT_SUPPORTED, TAG, "History requester has no short address");
+
+    /* Everything recorded so far has to be in flash before the walk over the blocks starts */
+    history_flush();
+
+    fetch.active   = true;
+    fetch.ep       = payload[0];
+    fetch.dst_addr = message->info.src_address.u.short_addr;
+    fetch.dst_ep   = message->info.src_endpoint;
+    memcpy(&fetch.from, &payload[1], sizeof(uint32_t));
+    memcpy(&fetch.to, &payload[5], sizeof(uint32_t));
+
+    /* Oldest block first: the one after the block being written */
+    fetch.block       = (block + 1) % block_count;
+    fetch.blocks_left = block_count;
+    fetch.offset      = 0;
+    fetch.value       = 0;
+    fetch.started_us  = esp_timer_get_time();
+
+    ESP_LOGI(TAG, "History fetch for endpoint %d, %lu..%lu s", fetch.ep, fetch.from, fetch.to);
+    esp_zb_scheduler_alarm(history_fetch_step, 0, 0);
+    return ESP_OK;
+}
+
+const history_stats_t *history_get_stats(void) { return &history_stats; }
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define HISTORY_CLUSTER_ID 0xFC03   /* Manufacturer-specific cluster giving access to the flash history */
+#define HISTORY_ATTR_TIME_ID 0x0000 /* U32: current history time in seconds, maps history timestamps to wall clock */
+#define HISTORY_CMD_FETCH_ID 0x00   /* To server: endpoint u8, from u32, to u32 (history time, little endian) */
+#define HISTORY_CMD_SAMPLES_ID 0x00 /* To client: endpoint u8, count u8, count x (time u32, value s16); count 0 ends the fetch */
+
+    typedef struct
+    {
+        uint32_t samples;       /* Readings stored */
+        uint32_t raw_bytes;     /* Size of the stored readings as time, endpoint and value without compression */
+        uint32_t encoded_bytes; /* Size of the encoded records */
+        uint32_t flash_bytes;   /* Bytes programmed, block headers included */
+        uint32_t erases;        /* Blocks erased */
+        uint32_t fetch_samples; /* Readings sent over Zigbee */
+        uint32_t fetch_frames;  /* Sample frames sent */
+        uint32_t fetch_time_us; /* Duration of the last completed fetch */
+    } history_stats_t;
+
+    void history_init(void);
+    void history_add_cluster(esp_zb_cluster_list_t *cluster_list, uint8_t ep);
+    void history_add(uint8_t ep, int16_t value);
+    void history_commit(void);
+    void history_flush(void);
+    esp_err_t history_handle_command(const esp_zb_zcl_custom_cluster_command_message_t *message);
+    const history_stats_t *history_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,7 @@
 #include "led_driver.h"
 
 #include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include <freertos/task.h>
 #include <stdint.h>
 
@@ -10,27 +11,156 @@
 #include "esp_log.h"
 
 #define MAX_LED_POWER 0x1F
+#define LED_PATTERN_STEP_MS 50 /* Animation step of blinking and fading patterns */
+#define LED_TX_TIMEOUT_MS 20   /* A 24-bit WS2812 frame takes 30 us, anything longer is an RMT fault */
 
 static const char *TAG = "led_driver.c";
 
+typedef enum
+{
+    LED_PATTERN_STEADY,
+    LED_PATTERN_BLINK,
+    LED_PATTERN_FADE,
+} led_pattern_t;
+
+typedef struct
+{
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    led_pattern_t pattern;
+    uint16_t period_ms;
+    uint8_t rank; /* A status of a higher rank stays until it is cleared, 0 is replaced by anything */
+} led_status_style_t;
+
+static const led_status_style_t led_status_styles[] = {
+    [LED_STATUS_OFF]           = {0, 0, 0, LED_PATTERN_STEADY, 0, 0},
+    [LED_STATUS_CONFIG]        = {0xFF, 0xFF, 0, LED_PATTERN_FADE, 2000, 3},
+    [LED_STATUS_NETWORK_ERROR] = {0xFF, 0, 0, LED_PATTERN_BLINK, 1000, 4},
+    [LED_STATUS_READING]       = {0, 0xFF, 0, LED_PATTERN_STEADY, 0, 0},
+    [LED_STATUS_READ_ERROR]    = {0, 0xFF, 0xFF, LED_PATTERN_BLINK, 400, 1},
+    [LED_STATUS_NO_SENSORS]    = {0xFF, 0, 0xFF, LED_PATTERN_STEADY, 0, 2},
+};
+
 // Конфигурация RMT для адресных светодиодов
 static rmt_channel_handle_t led_chan    = NULL;
 static rmt_encoder_handle_t led_encoder = NULL;
+static QueueHandle_t led_status_queue   = NULL;
+static led_status_t latched_status      = LED_STATUS_OFF; /* Highest ranked status not cleared yet */
 
-void led_driver_set(uint8_t red, uint8_t green, uint8_t blue)
+static void led_driver_write(uint8_t red, uint8_t green, uint8_t blue, uint8_t level)
 {
-    uint8_t led_data[3] = {
-        green & MAX_LED_POWER,
-        red & MAX_LED_POWER,
-        blue & MAX_LED_POWER,
-    };  // Порядок GRB для WS2812
+    static uint8_t led_data[3];
+
+    /* Wait for the previous frame before its buffer is overwritten; only the LED task gets here */
+    if (rmt_tx_wait_all_done(led_chan, LED_TX_TIMEOUT_MS) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "RMT transmission timed out");
+    }
+
+    led_data[0] = (green & MAX_LED_POWER) * level / 0xFF;
+    led_data[1] = (red & MAX_LED_POWER) * level / 0xFF;
+    led_data[2] = (blue & MAX_LED_POWER) * level / 0xFF;  // Порядок GRB для WS2812
 
     rmt_transmit_config_t tx_config = {
         .loop_count = 0,
     };
 
-    ESP_ERROR_CHECK(rmt_transmit(led_chan, led_encoder, led_data, sizeof(led_data), &tx_config));
-    ESP_ERROR_CHECK(rmt_tx_wait_all_done(led_chan, portMAX_DELAY));
+    esp_err_t err = rmt_transmit(led_chan, led_encoder, led_data, sizeof(led_data), &tx_config);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "RMT transmit failed: %s", esp_err_to_name(err));
+    }
+}
+
+static uint8_t led_pattern_level(const led_status_style_t *style, uint32_t elapsed_ms)
+{
+    uint32_t phase = elapsed_ms % style->period_ms;
+
+    switch (style->pattern)
+    {
+        case LED_PATTERN_BLINK:
+            return phase < style->period_ms / 2 ? 0xFF : 0;
+        case LED_PATTERN_FADE:
+        {
+            /* Triangle wave, linear in both directions */
+            uint32_t half = style->period_ms / 2;
+            return (phase < half ? phase : style->period_ms - phase) * 0xFF / half;
+        }
+        default:
+            return 0xFF;
+    }
+}
+
+static void led_driver_task(void *pvParameters)
+{
+    led_status_t status = LED_STATUS_OFF;
+    uint32_t elapsed_ms = 0;
+
+    while (true)
+    {
+        const led_status_style_t *style = &led_status_styles[status];
+#if ZB_SLEEPY_END_DEVICE
+        /* Animation would wake the CPU every step, a sleepy device only shows steady colors */
+        TickType_t wait = portMAX_DELAY;
+#else
+        TickType_t wait = style->pattern == LED_PATTERN_STEADY ? portMAX_DELAY : pdMS_TO_TICKS(LED_PATTERN_STEP_MS);
+#endif
+        led_status_t next;
+
+        if (xQueueReceive(led_status_queue, &next, wait) == pdTRUE)
+        {
+            if (next == status)
+            {
+                continue;
+            }
+            status     = next;
+            style      = &led_status_styles[status];
+            elapsed_ms = 0;
+        }
+        else
+        {
+            elapsed_ms += LED_PATTERN_STEP_MS;
+        }
+
+        uint8_t level = wait == portMAX_DELAY ? 0xFF : led_pattern_level(style, elapsed_ms);
+        led_driver_write(style->red, style->green, style->blue, level);
+    }
+}
+
+/* Never blocks: the queue holds only the latest status, so bursts of updates collapse into one */
+static void led_driver_post(led_status_t status)
+{
+    if (led_status_queue != NULL)
+    {
+        xQueueOverwrite(led_status_queue, &status);
+    }
+}
+
+/* Faults latch: the status shown every cycle cannot hide one before led_driver_clear_status(). Called from the
+   Zigbee task only, apart from led_driver_init(). */
+void led_driver_set_status(led_status_t status)
+{
+    if (led_status_styles[status].rank < led_status_styles[latched_status].rank)
+    {
+        return;
+    }
+    if (led_status_styles[status].rank > 0)
+    {
+        latched_status = status;
+    }
+    led_driver_post(status);
+}
+
+/* Ends a latched fault, a fault of lower rank shows again the next time it is set */
+void led_driver_clear_status(led_status_t status)
+{
+    if (latched_status != status)
+    {
+        return;
+    }
+    latched_status = LED_STATUS_OFF;
+    led_driver_post(LED_STATUS_OFF);
 }
 
 esp_err_t led_driver_init()
@@ -41,7 +171,7 @@ esp_err_t led_driver_init()
     rmt_tx_channel_config_t tx_chan_config = {
         .clk_src           = RMT_CLK_SRC_DEFAULT,
         .gpio_num          = RGB_LED_GPIO,
-        .mem_block_symbols = 64,
+        .mem_block_symbols = 48, /* One block, the other TX block is left for the RMT 1-Wire backend */
         .resolution_hz     = 10000000,  // 10 MHz
         .trans_queue_depth = 4,
         .flags.with_dma    = false,
@@ -70,6 +200,10 @@ esp_err_t led_driver_init()
     // Включить канал RMT
     ESP_RETURN_ON_ERROR(rmt_enable(led_chan), TAG, "enable RMT channel failed");
 
-    led_driver_set(0xFF, 0xFF, 0);
+    led_status_queue = xQueueCreate(1, sizeof(led_status_t));
+    ESP_RETURN_ON_FALSE(led_status_queue, ESP_ERR_NO_MEM, TAG, "create LED status queue failed");
+    ESP_RETURN_ON_FALSE(xTaskCreate(led_driver_task, "led_status", 2048, NULL, 1, NULL) == pdPASS, ESP_ERR_NO_MEM, TAG, "create LED task failed");
+
+    led_driver_set_status(LED_STATUS_CONFIG);
     return ESP_OK;
 }
@@ -17,9 +17,20 @@ extern "C"
 #define CONFIG_EXAMPLE_STRIP_LED_GPIO 8
 #define CONFIG_EXAMPLE_STRIP_LED_NUMBER 1
 
-    void led_driver_set(uint8_t red, uint8_t green, uint8_t blue);
+    typedef enum
+    {
+        LED_STATUS_OFF,
+        LED_STATUS_CONFIG,        /* Yellow, fading */
+        LED_STATUS_NETWORK_ERROR, /* Red, blinking */
+        LED_STATUS_READING,       /* Green */
+        LED_STATUS_READ_ERROR,    /* Cyan, blinking */
+        LED_STATUS_NO_SENSORS,    /* Magenta */
+    } led_status_t;
+
+    void led_driver_set_status(led_status_t status);
+    void led_driver_clear_status(led_status_t status);
     esp_err_t led_driver_init();
 
 #ifdef __cplusplus
 }  // extern "C"
-#endif
\ No newline at end of file
+#endif
@@ -3,30 +3,75 @@
 #include "config.h"
 #include "esp_check.h"
 #include "esp_log.h"
+#include "esp_random.h"
+#include "event_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "ha/esp_zigbee_ha_standard.h"
+#include "history.h"
 #include "led_driver.h"
 #include "nvs_flash.h"
+#include "ota.h"
+#include "power.h"
+#include "sensor_config.h"
 #include "thermometer.h"
 
 
 static const char* TAG = "main.c";
 
+static uint8_t commissioning_failures = 0;
+
 static void bdb_start_top_level_commissioning_cb(uint8_t mode_mask)
 {
     ESP_RETURN_ON_FALSE(esp_zb_bdb_start_top_level_commissioning(mode_mask) == ESP_OK, , TAG, "Failed to start Zigbee commissioning");
 }
 
+/* Exponential backoff with jitter, so devices that lost the network together do not retry in lockstep */
+static void commissioning_retry(uint8_t mode_mask)
+{
+    uint32_t delay_ms = ZB_COMMISSIONING_RETRY_MAX_MS;
+    if (commissioning_failures < 16 && (ZB_COMMISSIONING_RETRY_MIN_MS << commissioning_failures) < ZB_COMMISSIONING_RETRY_MAX_MS)
+    {
+        delay_ms = ZB_COMMISSIONING_RETRY_MIN_MS << commissioning_failures;
+    }
+    if (commissioning_failures < UINT8_MAX)
+    {
+        commissioning_failures++;
+    }
+
+    /* Somewhere in the upper half of the backoff */
+    delay_ms = delay_ms / 2 + esp_random() % (delay_ms / 2 + 1);
+    ESP_LOGI(TAG, "Retrying commissioning in %lu ms (attempt %d)", delay_ms, commissioning_failures);
+    esp_zb_scheduler_alarm((esp_zb_callback_t)bdb_start_top_level_commissioning_cb, mode_mask, delay_ms);
+}
+
+static void network_joined(void)
+{
+    commissioning_failures = 0;
+    led_driver_clear_status(LED_STATUS_NETWORK_ERROR);
+    led_driver_clear_status(LED_STATUS_CONFIG);
+#if ZB_OTA_ENABLE
+    ota_confirm_image();
+#endif
+    thermometer_network_joined();
+}
+
 void esp_zb_app_signal_handler(esp_zb_app_signal_t* signal_struct)
 {
     uint32_t* p_sg_p                  = signal_struct->p_app_signal;
     esp_err_t err_status              = signal_struct->esp_err_status;
     esp_zb_app_signal_type_t sig_type = *p_sg_p;
 
-    ESP_LOGI(TAG, "signal type received: %s", signal_type_to_string(sig_type));
+    if (sig_type != ESP_ZB_COMMON_SIGNAL_CAN_SLEEP)
+    {
+        event_log_record(EVENT_LOG_ZB_SIGNAL, 0, sig_type, err_status);
+    }
+
     switch (sig_type)
     {
+        case ESP_ZB_COMMON_SIGNAL_CAN_SLEEP:
+            power_sleep();
+            break;
         case ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP:
             esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_INITIALIZATION);
             break;
@@ -38,18 +83,22 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t* signal_struct)
                 {
                     ESP_LOGI(TAG, "Start network steering");
                     esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING);
+                    led_driver_set_status(LED_STATUS_OFF);
+                }
+                else
+                {
+                    /* Initialization rejoined with the network parameters kept in NVS, no steering needed */
+                    ESP_LOGI(TAG, "Rejoined network (PAN ID: 0x%04hx, Channel:%d)", esp_zb_get_pan_id(), esp_zb_get_current_channel());
+                    network_joined();
                 }
-
-                led_driver_set(0, 0, 0);
             }
             else
             {
-                /* commissioning failed */
+                /* Retry initialization in place, for a device that was on a network it is a rejoin with the stored parameters */
                 ESP_LOGW(TAG, "Failed to initialize Zigbee stack (status: %s)", esp_err_to_name(err_status));
 
-                led_driver_set(0xFF, 0, 0);
-                vTaskDelay(pdMS_TO_TICKS(5000));
-                esp_restart();
+                led_driver_set_status(LED_STATUS_NETWORK_ERROR);
+                commissioning_retry(ESP_ZB_BDB_MODE_INITIALIZATION);
             }
             break;
         case ESP_ZB_BDB_SIGNAL_STEERING:
@@ -73,11 +122,12 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t* signal_struct)
                     esp_zb_get_pan_id(),
                     esp_zb_get_current_channel(),
                     esp_zb_get_short_address());
+                network_joined();
             }
             else
             {
                 ESP_LOGI(TAG, "Network steering was not successful (status: %s)", esp_err_to_name(err_status));
-                esp_zb_scheduler_alarm((esp_zb_callback_t)bdb_start_top_level_commissioning_cb, ESP_ZB_BDB_MODE_NETWORK_STEERING, 1000);
+                commissioning_retry(ESP_ZB_BDB_MODE_NETWORK_STEERING);
             }
             break;
         default:
@@ -100,6 +150,8 @@ static esp_err_t zb_attribute_handler(const esp_zb_zcl_set_attr_value_message_t*
         message->info.cluster,
         message->attribute.id,
         message->attribute.data.size);
+
+    ret = thermometer_set_attribute(message);
     return ret;
 }
 
@@ -109,21 +161,27 @@ static esp_err_t zb_default_response_handler(const esp_zb_zcl_cmd_default_resp_m
 
     ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty default response message");
 
-    ESP_LOGI(
-        TAG,
-        "Received default response: endpoint(%d), cluster(0x%x), command(0x%x), status(0x%x)",
-        message->info.dst_endpoint,
-        message->info.cluster,
-        message->resp_to_cmd,
-        message->status_code);
+    event_log_record(EVENT_LOG_DEFAULT_RESPONSE, message->info.dst_endpoint, message->info.cluster, message->resp_to_cmd << 8 | message->status_code);
+
+    return ret;
+}
+
+static esp_err_t zb_custom_cluster_handler(const esp_zb_zcl_custom_cluster_command_message_t* message)
+{
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty custom cluster message");
+    ESP_LOGI(TAG, "Received custom command: endpoint(%d), cluster(0x%x), command(0x%x)", message->info.dst_endpoint, message->info.cluster, message->info.command.id);
 
-    // Handle specific status codes if needed
-    if (message->status_code != ESP_ZB_ZCL_STATUS_SUCCESS)
+    if (message->info.cluster == SENSOR_CONFIG_CLUSTER_ID)
     {
-        ESP_LOGW(TAG, "Default response indicates error status: 0x%x", message->status_code);
+        return thermometer_handle_command(message);
     }
-
-    return ret;
+#if DS18B20_HISTORY_ENABLE
+    if (message->info.cluster == HISTORY_CLUSTER_ID)
+    {
+        return history_handle_command(message);
+    }
+#endif
+    return ESP_ERR_NOT_SUPPORTED;
 }
 
 static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const void* message)
@@ -137,6 +195,14 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
         case ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID:
             ret = zb_default_response_handler((esp_zb_zcl_cmd_default_resp_message_t*)message);
             break;
+        case ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID:
+            ret = zb_custom_cluster_handler((esp_zb_zcl_custom_cluster_command_message_t*)message);
+            break;
+#if ZB_OTA_ENABLE
+        case ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID:
+            ret = ota_handle_upgrade((esp_zb_zcl_ota_upgrade_value_message_t*)message);
+            break;
+#endif
         default:
             ESP_LOGW(TAG, "Receive Zigbee action(0x%x) callback", callback_id);
             break;
@@ -149,6 +215,7 @@ static void esp_zb_task(void* pvParameters)
     /* initialize Zigbee stack */
     esp_zb_cfg_t zb_nwk_cfg = ESP_ZB_ZED_CONFIG();
     esp_zb_init(&zb_nwk_cfg);
+    power_configure_stack();
 
     thermometer_add_endpoints();
 
@@ -160,14 +227,20 @@ static void esp_zb_task(void* pvParameters)
 
 void app_main(void)
 {
+    ESP_ERROR_CHECK(nvs_flash_init());
+    ESP_ERROR_CHECK(power_init());
+    ESP_ERROR_CHECK(event_log_init());
+
     led_driver_init();
     thermometer_init();
+#if DS18B20_HISTORY_ENABLE
+    history_init();
+#endif
 
     esp_zb_platform_config_t config = {
         .radio_config = ESP_ZB_DEFAULT_RADIO_CONFIG(),
         .host_config  = ESP_ZB_DEFAULT_HOST_CONFIG(),
     };
-    ESP_ERROR_CHECK(nvs_flash_init());
     ESP_ERROR_CHECK(esp_zb_platform_config(&config));
 
     xTaskCreate(esp_zb_task, "Zigbee_main", 8192, NULL, 5, NULL);
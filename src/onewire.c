@@ -0,0 +1,268 @@
+#include "onewire.h"
+
+#include <string.h>
+
+#define ONEWIRE_ROM_SIZE 8
+
+esp_err_t onewire_init(onewire_bus_t *bus, const onewire_backend_t *backend, gpio_num_t pin)
+{
+    memset(bus, 0, sizeof(onewire_bus_t));
+    bus->backend    = backend;
+    bus->pin        = pin;
+    bus->resolution = 12;
+    return backend->init(bus);
+}
+
+bool onewire_reset(onewire_bus_t *bus)
+{
+    bus->stats.resets++;
+    return bus->backend->reset(bus);
+}
+
+uint8_t onewire_read_bit(onewire_bus_t *bus)
+{
+    bus->stats.bits++;
+    return bus->backend->touch_bit(bus, 1);
+}
+
+void onewire_write_bit(onewire_bus_t *bus, uint8_t bit)
+{
+    bus->stats.bits++;
+    bus->backend->touch_bit(bus, bit);
+}
+
+void onewire_write_bytes(onewire_bus_t *bus, const uint8_t *data, uint8_t len)
+{
+    bus->stats.bytes += len;
+    bus->backend->write_bytes(bus, data, len);
+}
+
+void onewire_write_byte(onewire_bus_t *bus, uint8_t byte) { onewire_write_bytes(bus, &byte, 1); }
+
+void onewire_read_bytes(onewire_bus_t *bus, uint8_t *data, uint8_t len)
+{
+    bus->stats.bytes += len;
+    bus->backend->read_bytes(bus, data, len);
+}
+
+uint8_t onewire_crc8(const uint8_t *data, uint8_t len)
+{
+    uint8_t crc = 0;
+
+    while (len--)
+    {
+        uint8_t byte = *data++;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix)
+            {
+                crc ^= 0x8C;
+            }
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+/* Reset followed by Match ROM, or by Skip ROM when addr is NULL to address every device of the bus */
+bool onewire_select(onewire_bus_t *bus, const uint8_t *addr)
+{
+    if (!onewire_reset(bus))
+    {
+        return false;
+    }
+
+    if (addr == NULL)
+    {
+        onewire_write_byte(bus, ONEWIRE_CMD_SKIP_ROM);
+        return true;
+    }
+
+    uint8_t command[1 + ONEWIRE_ROM_SIZE] = {ONEWIRE_CMD_MATCH_ROM};
+    memcpy(&command[1], addr, ONEWIRE_ROM_SIZE);
+    onewire_write_bytes(bus, command, sizeof(command));
+    return true;
+}
+
+void onewire_search_reset(onewire_bus_t *bus)
+{
+    bus->search.last_discrepancy        = 0;
+    bus->search.last_device             = false;
+    bus->search.last_family_discrepancy = 0;
+    memset(bus->search.rom_no, 0, sizeof(bus->search.rom_no));
+}
+
+/* Maxim application note 187 search, shared by Search ROM and Alarm Search.
+   Returns 1 when a device was found, 0 when the search is complete and -1 on a bus error. */
+int onewire_search(onewire_bus_t *bus, uint8_t command, uint8_t *addr)
+{
+    uint8_t *rom_no         = bus->search.rom_no;
+    uint8_t id_bit_number   = 1;
+    uint8_t last_zero       = 0;
+    uint8_t rom_byte_number = 0;
+    uint8_t rom_byte_mask   = 1;
+
+    if (bus->search.last_device || !onewire_reset(bus))
+    {
+        onewire_search_reset(bus);
+        return 0;
+    }
+
+    onewire_write_byte(bus, command);
+
+    do
+    {
+        uint8_t id_bit     = onewire_read_bit(bus);
+        uint8_t cmp_id_bit = onewire_read_bit(bus);
+        uint8_t direction;
+
+        if (id_bit && cmp_id_bit)
+        {
+            break;
+        }
+
+        if (id_bit != cmp_id_bit)
+        {
+            direction = id_bit;
+        }
+        else
+        {
+            if (id_bit_number < bus->search.last_discrepancy)
+            {
+                direction = (rom_no[rom_byte_number] & rom_byte_mask) != 0;
+            }
+            else
+            {
+                direction = id_bit_number == bus->search.last_discrepancy;
+            }
+
+            if (direction == 0)
+            {
+                last_zero = id_bit_number;
+                if (last_zero < 9)
+                {
+                    bus->search.last_family_discrepancy = last_zero;
+                }
+            }
+        }
+
+        if (direction)
+        {
+            rom_no[rom_byte_number] |= rom_byte_mask;
+        }
+        else
+        {
+            rom_no[rom_byte_number] &= ~rom_byte_mask;
+        }
+        onewire_write_bit(bus, direction);
+
+        id_bit_number++;
+        rom_byte_mask <<= 1;
+        if (rom_byte_mask == 0)
+        {
+            rom_byte_number++;
+            rom_byte_mask = 1;
+        }
+    } while (rom_byte_number < ONEWIRE_ROM_SIZE);
+
+    if (id_bit_number == 1)
+    {
+        /* Nobody answered, e.g. no device is in alarm state */
+        onewire_search_reset(bus);
+        return 0;
+    }
+
+    if (rom_byte_number < ONEWIRE_ROM_SIZE || onewire_crc8(rom_no, ONEWIRE_ROM_SIZE - 1) != rom_no[ONEWIRE_ROM_SIZE - 1])
+    {
+        onewire_search_reset(bus);
+        return -1;
+    }
+
+    bus->search.last_discrepancy = last_zero;
+    if (last_zero == 0)
+    {
+        bus->search.last_device = true;
+    }
+
+    memcpy(addr, rom_no, ONEWIRE_ROM_SIZE);
+    return 1;
+}
+
+/* Starts a conversion on one device, or on every device of the bus when addr is NULL. On a parasite-powered
+   bus the line is then driven high, the devices draw the conversion current through it and the datasheet
+   allows at most 10 us before it has to be there. It stays driven until onewire_strong_pullup_release(). */
+bool ds18b20_convert(onewire_bus_t *bus, const uint8_t *addr)
+{
+    if (!onewire_select(bus, addr))
+    {
+        return false;
+    }
+
+    onewire_write_byte(bus, DS18B20_CMD_CONVERT_T);
+    if (bus->parasite)
+    {
+        bus->backend->strong_pullup(bus, true);
+    }
+    return true;
+}
+
+void onewire_strong_pullup_release(onewire_bus_t *bus) { bus->backend->strong_pullup(bus, false); }
+
+/* Read Power Supply addressed to every device, a parasite-powered one pulls the read slot low */
+bool ds18b20_parasite_powered(onewire_bus_t *bus)
+{
+    if (!onewire_select(bus, NULL))
+    {
+        return false;
+    }
+
+    onewire_write_byte(bus, DS18B20_CMD_READ_POWER_SUPPLY);
+    return onewire_read_bit(bus) == 0;
+}
+
+/* Reads the first len bytes of the scratchpad, addr NULL reads the only device of the bus. The device stops
+   sending at the next reset, so a truncated read costs nothing extra, but only a full one is verified.
+   ESP_ERR_NOT_FOUND when nothing answers the reset, ESP_ERR_INVALID_CRC when the data is corrupt. */
+esp_err_t ds18b20_read_scratchpad(onewire_bus_t *bus, const uint8_t *addr, uint8_t *scratchpad, uint8_t len)
+{
+    if (!onewire_select(bus, addr))
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    onewire_write_byte(bus, DS18B20_CMD_READ_SCRATCHPAD);
+
+    onewire_read_bytes(bus, scratchpad, len);
+
+    if (len < DS18B20_SCRATCHPAD_SIZE)
+    {
+        return ESP_OK;
+    }
+
+    uint8_t or_bits = 0;
+    for (uint8_t i = 0; i < DS18B20_SCRATCHPAD_SIZE; i++)
+    {
+        or_bits |= scratchpad[i];
+    }
+
+    /* An all-zero scratchpad passes the CRC check, but only a shorted bus reads like that */
+    if (or_bits == 0 || onewire_crc8(scratchpad, DS18B20_SCRATCHPAD_SIZE - 1) != scratchpad[DS18B20_SCRATCHPAD_SIZE - 1])
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+/* Writes TH, TL and the configuration register to the scratchpad only, the EEPROM is left untouched */
+bool ds18b20_write_scratchpad(onewire_bus_t *bus, const uint8_t *addr, int8_t th, int8_t tl, uint8_t resolution)
+{
+    if (!onewire_select(bus, addr))
+    {
+        return false;
+    }
+
+    uint8_t command[] = {DS18B20_CMD_WRITE_SCRATCHPAD, (uint8_t)th, (uint8_t)tl, DS18B20_CONFIG_RESOLUTION(resolution)};
+    onewire_write_bytes(bus, command, sizeof(command));
+    return true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ONEWIRE_CMD_SEARCH_ROM 0xF0
+#define ONEWIRE_CMD_ALARM_SEARCH 0xEC
+#define ONEWIRE_CMD_MATCH_ROM 0x55
+#define ONEWIRE_CMD_SKIP_ROM 0xCC
+
+#define DS18B20_FAMILY_CODE 0x28
+
+#define DS18B20_CMD_CONVERT_T 0x44
+#define DS18B20_CMD_WRITE_SCRATCHPAD 0x4E
+#define DS18B20_CMD_READ_SCRATCHPAD 0xBE
+#define DS18B20_CMD_READ_POWER_SUPPLY 0xB4
+
+#define DS18B20_SCRATCHPAD_SIZE 9
+#define DS18B20_SCRATCHPAD_TEMPERATURE_SIZE 2 /* Temperature register, LSB first */
+#define DS18B20_SCRATCHPAD_TH 2
+#define DS18B20_SCRATCHPAD_TL 3
+#define DS18B20_SCRATCHPAD_CONFIG 4
+#define DS18B20_SCRATCHPAD_RESERVED 6
+
+#define DS18B20_POWER_ON_RESET_RAW 0x0550    /* 85 °C left in the temperature register by a power-on reset */
+#define DS18B20_POWER_ON_RESET_RESERVED 0x0C /* Reserved byte 6 after a power-on reset, 0x10 minus the fraction after a conversion */
+
+#define DS18B20_CONFIG_RESOLUTION(resolution) ((((resolution) - 9) << 5) | 0x1F) /* Configuration register value for resolution */
+
+    typedef struct onewire_bus onewire_bus_t;
+
+    /* Line-level operations of a bus, everything above them is shared by the backends */
+    typedef struct
+    {
+        esp_err_t (*init)(onewire_bus_t *bus);
+        bool (*reset)(onewire_bus_t *bus);                     /* true on a presence pulse */
+        uint8_t (*touch_bit)(onewire_bus_t *bus, uint8_t bit); /* a 1 slot doubles as a read slot and returns the bit read */
+        void (*write_bytes)(onewire_bus_t *bus, const uint8_t *data, uint8_t len);
+        void (*read_bytes)(onewire_bus_t *bus, uint8_t *data, uint8_t len);
+        void (*strong_pullup)(onewire_bus_t *bus, bool enable);
+    } onewire_backend_t;
+
+    /* Maxim application note 187 search state */
+    typedef struct
+    {
+        uint8_t last_discrepancy;
+        bool last_device;
+        uint8_t last_family_discrepancy;
+        uint8_t rom_no[8];
+    } onewire_search_state_t;
+
+    typedef struct
+    {
+        uint32_t bytes;  /* Bytes written and read */
+        uint32_t bits;   /* Single slots, e.g. during a search */
+        uint32_t resets; /* Reset and presence sequences */
+        uint32_t cpu_us; /* CPU time spent in the backend, time blocked waiting for hardware excluded */
+    } onewire_bus_stats_t;
+
+    struct onewire_bus
+    {
+        const onewire_backend_t *backend;
+        gpio_num_t pin;
+        bool parasite;          /* A device on the bus takes its power from the data line */
+        uint8_t devices;        /* Devices known on the bus, a single one is addressed with Skip ROM */
+        bool devices_confirmed; /* devices comes from a search that walked the whole bus */
+        uint8_t resolution;     /* Highest conversion resolution on the bus */
+        onewire_search_state_t search;
+        onewire_bus_stats_t stats;
+        void *ctx; /* Backend state */
+    };
+
+    extern const onewire_backend_t onewire_gpio_backend; /* Software-timed slots through the DS18B20 library */
+    extern const onewire_backend_t onewire_rmt_backend;  /* Slots generated and sampled by the RMT peripheral */
+    extern const onewire_backend_t onewire_sim_backend;  /* Simulated DS18B20 devices, no hardware involved */
+
+    esp_err_t onewire_init(onewire_bus_t *bus, const onewire_backend_t *backend, gpio_num_t pin);
+    bool onewire_reset(onewire_bus_t *bus);
+    uint8_t onewire_read_bit(onewire_bus_t *bus);
+    void onewire_write_bit(onewire_bus_t *bus, uint8_t bit);
+    void onewire_write_byte(onewire_bus_t *bus, uint8_t byte);
+    void onewire_write_bytes(onewire_bus_t *bus, const uint8_t *data, uint8_t len);
+    void onewire_read_bytes(onewire_bus_t *bus, uint8_t *data, uint8_t len);
+
+    uint8_t onewire_crc8(const uint8_t *data, uint8_t len);
+    bool onewire_select(onewire_bus_t *bus, const uint8_t *addr);
+    void onewire_search_reset(onewire_bus_t *bus);
+    int onewire_search(onewire_bus_t *bus, uint8_t command, uint8_t *addr);
+
+    bool ds18b20_convert(onewire_bus_t *bus, const uint8_t *addr);
+    void onewire_strong_pullup_release(onewire_bus_t *bus);
+    bool ds18b20_parasite_powered(onewire_bus_t *bus);
+    esp_err_t ds18b20_read_scratchpad(onewire_bus_t *bus, const uint8_t *addr, uint8_t *scratchpad, uint8_t len);
+    bool ds18b20_write_scratchpad(onewire_bus_t *bus, const uint8_t *addr, int8_t th, int8_t tl, uint8_t resolution);
+
+#ifdef __cplusplus
+}
+#endif
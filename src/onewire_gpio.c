@@ -0,0 +1,88 @@
+#include <stdlib.h>
+
+#include "ds18b20.h"
+#include "esp_timer.h"
+#include "onewire.h"
+
+/* Slots are timed in software by the DS18B20 library, the CPU is busy for the whole transfer */
+
+static esp_err_t onewire_gpio_init(onewire_bus_t *bus)
+{
+    ds18b20_dev_t *dev = calloc(1, sizeof(ds18b20_dev_t));
+    if (dev == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    dev->pin           = bus->pin;
+    dev->bitResolution = bus->resolution;
+    ds18b20_init(dev, bus->pin);
+    bus->ctx = dev;
+    return ESP_OK;
+}
+
+static bool onewire_gpio_reset(onewire_bus_t *bus)
+{
+    int64_t started_us = esp_timer_get_time();
+    bool present       = ds18b20_reset(bus->ctx);
+    bus->stats.cpu_us += esp_timer_get_time() - started_us;
+    return present;
+}
+
+static uint8_t onewire_gpio_touch_bit(onewire_bus_t *bus, uint8_t bit)
+{
+    int64_t started_us = esp_timer_get_time();
+    uint8_t value      = 0;
+    if (bit)
+    {
+        value = ds18b20_read(bus->ctx);
+    }
+    else
+    {
+        ds18b20_write(bus->ctx, 0);
+    }
+    bus->stats.cpu_us += esp_timer_get_time() - started_us;
+    return value;
+}
+
+static void onewire_gpio_write_bytes(onewire_bus_t *bus, const uint8_t *data, uint8_t len)
+{
+    int64_t started_us = esp_timer_get_time();
+    for (uint8_t i = 0; i < len; i++)
+    {
+        ds18b20_write_byte(bus->ctx, data[i]);
+    }
+    bus->stats.cpu_us += esp_timer_get_time() - started_us;
+}
+
+static void onewire_gpio_read_bytes(onewire_bus_t *bus, uint8_t *data, uint8_t len)
+{
+    int64_t started_us = esp_timer_get_time();
+    for (uint8_t i = 0; i < len; i++)
+    {
+        data[i] = ds18b20_read_byte(bus->ctx);
+    }
+    bus->stats.cpu_us += esp_timer_get_time() - started_us;
+}
+
+static void onewire_gpio_strong_pullup(onewire_bus_t *bus, bool enable)
+{
+    if (enable)
+    {
+        gpio_set_level(bus->pin, 1);
+        gpio_set_direction(bus->pin, GPIO_MODE_OUTPUT);
+    }
+    else
+    {
+        gpio_set_direction(bus->pin, GPIO_MODE_INPUT);
+    }
+}
+
+const onewire_backend_t onewire_gpio_backend = {
+    .init          = onewire_gpio_init,
+    .reset         = onewire_gpio_reset,
+    .touch_bit     = onewire_gpio_touch_bit,
+    .write_bytes   = onewire_gpio_write_bytes,
+    .read_bytes    = onewire_gpio_read_bytes,
+    .strong_pullup = onewire_gpio_strong_pullup,
+};
@@ -0,0 +1,268 @@
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/rmt_rx.h"
+#include "driver/rmt_tx.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "hal/gpio_ll.h"
+#include "onewire.h"
+#include "onewire_rmt_codec.h"
+
+#define ONEWIRE_RMT_RESOLUTION_HZ 1000000 /* 1 us per tick, the codec works in us */
+#define ONEWIRE_RMT_MEM_SYMBOLS 48        /* One memory block of the ESP32-C6 */
+#define ONEWIRE_RMT_TX_BYTES 9            /* Match ROM in one transaction */
+#define ONEWIRE_RMT_RX_BYTES 4            /* Read slots per transaction, the capture has to fit one memory block */
+#define ONEWIRE_RMT_TIMEOUT_MS 50         /* A 9-byte transaction takes under 5 ms, anything longer is an RMT fault */
+
+_Static_assert(sizeof(onewire_rmt_symbol_t) == sizeof(rmt_symbol_word_t), "onewire_rmt_symbol_t does not match rmt_symbol_word_t");
+_Static_assert(ONEWIRE_RMT_RX_BYTES * 8 <= ONEWIRE_RMT_MEM_SYMBOLS, "ONEWIRE_RMT_RX_BYTES does not fit the RX memory block");
+
+static const char *TAG = "onewire_rmt.c";
+
+/*
+ * TX and RX channels share the pin: TX drives it open-drain with the loopback into the
+ * GPIO matrix, RX captures the resulting line including what the devices pull low.
+ * Slots are timed by the peripheral, so interrupts from the radio can only delay a
+ * transaction, never stretch a slot.
+ */
+typedef struct
+{
+    rmt_channel_handle_t tx;
+    rmt_channel_handle_t rx;
+    rmt_encoder_handle_t encoder;
+    QueueHandle_t rx_done;
+    onewire_rmt_symbol_t tx_symbols[ONEWIRE_RMT_TX_BYTES * 8];
+    onewire_rmt_symbol_t rx_symbols[ONEWIRE_RMT_MEM_SYMBOLS];
+} onewire_rmt_t;
+
+static const rmt_transmit_config_t onewire_rmt_tx_config = {
+    .loop_count      = 0,
+    .flags.eot_level = 1, /* Leave the line released */
+};
+
+static const rmt_receive_config_t onewire_rmt_rx_config = {
+    .signal_range_min_ns = 1000,                                                      /* Glitch filter */
+    .signal_range_max_ns = (ONEWIRE_RMT_RESET_PULSE + ONEWIRE_RMT_RESET_WAIT) * 1000, /* Line idle, capture complete */
+};
+
+static bool IRAM_ATTR onewire_rmt_rx_done(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata, void *user_data)
+{
+    BaseType_t woken = pdFALSE;
+    size_t count     = edata->num_symbols;
+
+    xQueueSendFromISR((QueueHandle_t)user_data, &count, &woken);
+    return woken == pdTRUE;
+}
+
+/* Sends the prepared symbols, with capture returns the number of captured symbols, 0 on a fault */
+static size_t onewire_rmt_transfer(onewire_bus_t *bus, size_t count, bool capture, int64_t started_us)
+{
+    onewire_rmt_t *rmt = bus->ctx;
+    size_t captured    = 0;
+
+    if (capture && rmt_receive(rmt->rx, rmt->rx_symbols, sizeof(rmt->rx_symbols), &onewire_rmt_rx_config) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "RMT receive failed on GPIO %d", bus->pin);
+        return 0;
+    }
+    if (rmt_transmit(rmt->tx, rmt->encoder, rmt->tx_symbols, count * sizeof(onewire_rmt_symbol_t), &onewire_rmt_tx_config) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "RMT transmit failed on GPIO %d", bus->pin);
+        return 0;
+    }
+    bus->stats.cpu_us += esp_timer_get_time() - started_us;
+
+    /* The task is blocked from here on, the peripheral does the timing */
+    if (rmt_tx_wait_all_done(rmt->tx, ONEWIRE_RMT_TIMEOUT_MS) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "RMT transmission timed out on GPIO %d", bus->pin);
+        return 0;
+    }
+    if (capture && xQueueReceive(rmt->rx_done, &captured, pdMS_TO_TICKS(ONEWIRE_RMT_TIMEOUT_MS)) != pdTRUE)
+    {
+        ESP_LOGW(TAG, "RMT capture timed out on GPIO %d", bus->pin);
+        return 0;
+    }
+    return capture ? captured : count;
+}
+
+static void onewire_rmt_free(onewire_rmt_t *rmt)
+{
+    if (rmt->tx != NULL)
+    {
+        rmt_del_channel(rmt->tx);
+    }
+    if (rmt->rx != NULL)
+    {
+        rmt_del_channel(rmt->rx);
+    }
+    if (rmt->encoder != NULL)
+    {
+        rmt_del_encoder(rmt->encoder);
+    }
+    if (rmt->rx_done != NULL)
+    {
+        vQueueDelete(rmt->rx_done);
+    }
+    free(rmt);
+}
+
+/* Every failure disables and deletes what was set up, so the pin is left free for another backend */
+static esp_err_t onewire_rmt_init(onewire_bus_t *bus)
+{
+    esp_err_t ret      = ESP_OK;
+    onewire_rmt_t *rmt = calloc(1, sizeof(onewire_rmt_t));
+    ESP_RETURN_ON_FALSE(rmt, ESP_ERR_NO_MEM, TAG, "Out of memory for the RMT bus");
+
+    rmt_rx_channel_config_t rx_chan_config = {
+        .clk_src           = RMT_CLK_SRC_DEFAULT,
+        .gpio_num          = bus->pin,
+        .mem_block_symbols = ONEWIRE_RMT_MEM_SYMBOLS,
+        .resolution_hz     = ONEWIRE_RMT_RESOLUTION_HZ,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_rx_channel(&rx_chan_config, &rmt->rx), err, TAG, "create RMT RX channel failed");
+
+    /* Created after RX so the pin ends up driven by TX, open-drain with the loopback RX listens on */
+    rmt_tx_channel_config_t tx_chan_config = {
+        .clk_src            = RMT_CLK_SRC_DEFAULT,
+        .gpio_num           = bus->pin,
+        .mem_block_symbols  = ONEWIRE_RMT_MEM_SYMBOLS,
+        .resolution_hz      = ONEWIRE_RMT_RESOLUTION_HZ,
+        .trans_queue_depth  = 1,
+        .flags.io_loop_back = true,
+        .flags.io_od_mode   = true,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_tx_channel(&tx_chan_config, &rmt->tx), err, TAG, "create RMT TX channel failed");
+
+    rmt_copy_encoder_config_t copy_encoder_config = {};
+    ESP_GOTO_ON_ERROR(rmt_new_copy_encoder(&copy_encoder_config, &rmt->encoder), err, TAG, "create RMT encoder failed");
+
+    rmt->rx_done = xQueueCreate(1, sizeof(size_t));
+    ESP_GOTO_ON_FALSE(rmt->rx_done, ESP_ERR_NO_MEM, err, TAG, "create RMT queue failed");
+
+    rmt_rx_event_callbacks_t callbacks = {
+        .on_recv_done = onewire_rmt_rx_done,
+    };
+    ESP_GOTO_ON_ERROR(rmt_rx_register_event_callbacks(rmt->rx, &callbacks, rmt->rx_done), err, TAG, "register RMT callback failed");
+    ESP_GOTO_ON_ERROR(rmt_enable(rmt->rx), err, TAG, "enable RMT RX channel failed");
+    ESP_GOTO_ON_ERROR(rmt_enable(rmt->tx), err_rx, TAG, "enable RMT TX channel failed");
+    gpio_pullup_en(bus->pin);
+    bus->ctx = rmt;
+
+    /* The TX output idles low until the first transmission ends on the release level */
+    rmt->tx_symbols[0] = (onewire_rmt_symbol_t){.level0 = 1, .duration0 = 1, .level1 = 1, .duration1 = 1};
+    ESP_GOTO_ON_FALSE(onewire_rmt_transfer(bus, 1, false, esp_timer_get_time()), ESP_FAIL, err_tx, TAG, "release the bus failed");
+    return ESP_OK;
+
+    /* Channels can only be deleted once disabled */
+err_tx:
+    rmt_disable(rmt->tx);
+err_rx:
+    rmt_disable(rmt->rx);
+err:
+    bus->ctx = NULL;
+    onewire_rmt_free(rmt);
+    return ret;
+}
+
+static bool onewire_rmt_reset(onewire_bus_t *bus)
+{
+    onewire_rmt_t *rmt = bus->ctx;
+    int64_t started_us = esp_timer_get_time();
+
+    size_t captured = onewire_rmt_transfer(bus, onewire_rmt_encode_reset(rmt->tx_symbols), true, started_us);
+
+    started_us   = esp_timer_get_time();
+    bool present = onewire_rmt_decode_presence(rmt->rx_symbols, captured);
+    bus->stats.cpu_us += esp_timer_get_time() - started_us;
+    return present;
+}
+
+static uint8_t onewire_rmt_touch_bit(onewire_bus_t *bus, uint8_t bit)
+{
+    onewire_rmt_t *rmt = bus->ctx;
+    int64_t started_us = esp_timer_get_time();
+    uint8_t value      = 0;
+
+    size_t captured = onewire_rmt_transfer(bus, onewire_rmt_encode_bits(rmt->tx_symbols, &bit, 1), bit != 0, started_us);
+    if (bit == 0)
+    {
+        return 0;
+    }
+
+    started_us = esp_timer_get_time();
+    if (!onewire_rmt_decode_bits(rmt->rx_symbols, captured, &value, 1))
+    {
+        /* An undecodable slot reads as the idle line */
+        value = 1;
+    }
+    bus->stats.cpu_us += esp_timer_get_time() - started_us;
+    return value;
+}
+
+static void onewire_rmt_write_bytes(onewire_bus_t *bus, const uint8_t *data, uint8_t len)
+{
+    onewire_rmt_t *rmt = bus->ctx;
+
+    while (len > 0)
+    {
+        uint8_t chunk      = len < ONEWIRE_RMT_TX_BYTES ? len : ONEWIRE_RMT_TX_BYTES;
+        int64_t started_us = esp_timer_get_time();
+        onewire_rmt_transfer(bus, onewire_rmt_encode_bits(rmt->tx_symbols, data, chunk * 8), false, started_us);
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+static void onewire_rmt_read_bytes(onewire_bus_t *bus, uint8_t *data, uint8_t len)
+{
+    static const uint8_t read_slots[ONEWIRE_RMT_RX_BYTES] = {0xFF, 0xFF, 0xFF, 0xFF};
+    onewire_rmt_t *rmt                                    = bus->ctx;
+
+    while (len > 0)
+    {
+        uint8_t chunk      = len < ONEWIRE_RMT_RX_BYTES ? len : ONEWIRE_RMT_RX_BYTES;
+        int64_t started_us = esp_timer_get_time();
+        size_t captured    = onewire_rmt_transfer(bus, onewire_rmt_encode_bits(rmt->tx_symbols, read_slots, chunk * 8), true, started_us);
+
+        started_us = esp_timer_get_time();
+        if (!onewire_rmt_decode_bits(rmt->rx_symbols, captured, data, chunk * 8))
+        {
+            /* The idle line, the CRC check of the caller rejects it */
+            memset(data, 0xFF, chunk);
+        }
+        bus->stats.cpu_us += esp_timer_get_time() - started_us;
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+/*
+ * Every transmission ends on the release level, so the TX output stays high. Turning off open-drain makes the pad
+ * drive that level. gpio_set_direction() would route the pin back to the GPIO output register, which is low, and
+ * detach TX, so only the pad driver bit is touched.
+ */
+static void onewire_rmt_strong_pullup(onewire_bus_t *bus, bool enable)
+{
+    if (enable)
+    {
+        gpio_ll_od_disable(&GPIO, bus->pin);
+    }
+    else
+    {
+        gpio_ll_od_enable(&GPIO, bus->pin);
+    }
+}
+
+const onewire_backend_t onewire_rmt_backend = {
+    .init          = onewire_rmt_init,
+    .reset         = onewire_rmt_reset,
+    .touch_bit     = onewire_rmt_touch_bit,
+    .write_bytes   = onewire_rmt_write_bytes,
+    .read_bytes    = onewire_rmt_read_bytes,
+    .strong_pullup = onewire_rmt_strong_pullup,
+};
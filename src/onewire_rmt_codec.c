@@ -0,0 +1,66 @@
+#include "onewire_rmt_codec.h"
+
+#include <string.h>
+
+/*
+ * Every slot starts with the master pulling the line low, so one symbol is one slot:
+ * level0 low for the pulled part, level1 high for the rest. The RX channel watches the
+ * same pin, a device answering a read slot stretches the low part of the captured symbol.
+ */
+
+size_t onewire_rmt_encode_reset(onewire_rmt_symbol_t *symbols)
+{
+    symbols[0] = (onewire_rmt_symbol_t){
+        .level0    = 0,
+        .duration0 = ONEWIRE_RMT_RESET_PULSE,
+        .level1    = 1,
+        .duration1 = ONEWIRE_RMT_RESET_WAIT,
+    };
+    return 1;
+}
+
+/* LSB first, a read slot is a 1 slot */
+size_t onewire_rmt_encode_bits(onewire_rmt_symbol_t *symbols, const uint8_t *data, size_t bits)
+{
+    for (size_t i = 0; i < bits; i++)
+    {
+        bool one   = data[i / 8] & (1 << (i % 8));
+        symbols[i] = (onewire_rmt_symbol_t){
+            .level0    = 0,
+            .duration0 = one ? ONEWIRE_RMT_SLOT_START : ONEWIRE_RMT_SLOT,
+            .level1    = 1,
+            .duration1 = one ? ONEWIRE_RMT_SLOT - ONEWIRE_RMT_SLOT_START + ONEWIRE_RMT_SLOT_RECOVERY : ONEWIRE_RMT_SLOT_RECOVERY,
+        };
+    }
+    return bits;
+}
+
+/* The capture starts with our own reset pulse, a present device pulls the line low again after it */
+bool onewire_rmt_decode_presence(const onewire_rmt_symbol_t *symbols, size_t count)
+{
+    return count >= 2 && symbols[0].level0 == 0 && symbols[0].duration0 >= ONEWIRE_RMT_RESET_PULSE - 5 &&
+           symbols[0].duration1 >= ONEWIRE_RMT_PRESENCE_WAIT_MIN && symbols[1].level0 == 0 && symbols[1].duration0 >= ONEWIRE_RMT_PRESENCE_MIN;
+}
+
+/* Returns false when the capture does not hold one slot per bit, e.g. after a glitch split a slot */
+bool onewire_rmt_decode_bits(const onewire_rmt_symbol_t *symbols, size_t count, uint8_t *data, size_t bits)
+{
+    if (count < bits)
+    {
+        return false;
+    }
+
+    memset(data, 0, (bits + 7) / 8);
+    for (size_t i = 0; i < bits; i++)
+    {
+        if (symbols[i].level0 != 0)
+        {
+            return false;
+        }
+        if (symbols[i].duration0 <= ONEWIRE_RMT_SAMPLE_TIME)
+        {
+            data[i / 8] |= 1 << (i % 8);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Slot timing in us, which is also the RMT tick at the 1 MHz resolution used by the backend */
+#define ONEWIRE_RMT_RESET_PULSE 500      /* Reset low time, 480 us minimum */
+#define ONEWIRE_RMT_RESET_WAIT 200       /* High time after reset, covers the presence pulse */
+#define ONEWIRE_RMT_PRESENCE_WAIT_MIN 15 /* Earliest presence pulse after the reset is released */
+#define ONEWIRE_RMT_PRESENCE_MIN 60      /* Shortest valid presence pulse */
+#define ONEWIRE_RMT_SLOT_START 2         /* Low time that starts a 1 or read slot */
+#define ONEWIRE_RMT_SLOT 60              /* Low time of a 0 slot, total length of any slot */
+#define ONEWIRE_RMT_SLOT_RECOVERY 2      /* High time between two slots */
+#define ONEWIRE_RMT_SAMPLE_TIME 15       /* A read slot low for longer than this carries a 0 */
+
+    /* Same layout as rmt_symbol_word_t, kept free of driver headers so the codec builds on a host */
+    typedef union
+    {
+        struct
+        {
+            uint16_t duration0 : 15;
+            uint16_t level0 : 1;
+            uint16_t duration1 : 15;
+            uint16_t level1 : 1;
+        };
+        uint32_t val;
+    } onewire_rmt_symbol_t;
+
+    size_t onewire_rmt_encode_reset(onewire_rmt_symbol_t *symbols);
+    size_t onewire_rmt_encode_bits(onewire_rmt_symbol_t *symbols, const uint8_t *data, size_t bits);
+    bool onewire_rmt_decode_presence(const onewire_rmt_symbol_t *symbols, size_t count);
+    bool onewire_rmt_decode_bits(const onewire_rmt_symbol_t *symbols, size_t count, uint8_t *data, size_t bits);
+
+#ifdef __cplusplus
+}
+#endif
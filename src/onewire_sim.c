@@ -0,0 +1,526 @@
+#include "onewire_sim.h"
+
+#include <string.h>
+
+#include "config.h"
+#include "esp_random.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "onewire.h"
+
+_Static_assert(DS18B20_SIM_DEVICES <= ONEWIRE_SIM_MAX_DEVICES, "DS18B20_SIM_DEVICES does not fit the selection mask");
+
+/*
+ * DS18B20 devices simulated slot by slot, so search, Match ROM and the wired-AND of
+ * several devices answering at once behave as on a real bus. Every reset and slot takes
+ * its bus time through esp_rom_delay_us, and a conversion is only done after the
+ * conversion time of its resolution. A parasite-powered conversion needs the strong
+ * pullup until then, otherwise the device is left with its power-on scratchpad. Bits the
+ * devices send can be flipped to model slots stretched by interrupt latency, which
+ * exercises the CRC and retry paths.
+ */
+
+typedef enum
+{
+    ONEWIRE_SIM_ROM_COMMAND,
+    ONEWIRE_SIM_MATCH_ROM,
+    ONEWIRE_SIM_SEARCH,
+    ONEWIRE_SIM_FUNCTION_COMMAND,
+    ONEWIRE_SIM_WRITE_SCRATCHPAD,
+    ONEWIRE_SIM_READ_SCRATCHPAD,
+    ONEWIRE_SIM_READ_POWER_SUPPLY,
+    ONEWIRE_SIM_DONE, /* Waiting for a reset, read slots return the released line */
+} onewire_sim_state_t;
+
+typedef struct
+{
+    int64_t done_us; /* When the running conversion is done, 0 when none runs */
+    int16_t raw;     /* Its result */
+    bool powered;    /* A parasite-powered conversion got the strong pullup */
+} onewire_sim_conversion_t;
+
+typedef struct
+{
+    bool used;
+    gpio_num_t pin;
+    uint8_t count;      /* Devices on the bus, connected or not */
+    uint32_t connected; /* Devices answering, one bit each */
+    bool parasite;
+    uint32_t bit_error_ppm;
+    uint8_t roms[ONEWIRE_SIM_MAX_DEVICES][8];
+    uint8_t scratchpads[ONEWIRE_SIM_MAX_DEVICES][DS18B20_SCRATCHPAD_SIZE];
+    int16_t temperatures[ONEWIRE_SIM_MAX_DEVICES];
+    onewire_sim_conversion_t conversions[ONEWIRE_SIM_MAX_DEVICES];
+    uint32_t selected; /* Devices taking part in the current transaction */
+    onewire_sim_state_t state;
+    uint8_t shift;    /* Bits written by the master, LSB first */
+    uint8_t bits;     /* Bits in shift */
+    uint8_t position; /* Byte of Match ROM and Write Scratchpad, bit of a search or Read Scratchpad */
+    uint8_t search_phase;
+    uint8_t match[8];
+    onewire_sim_stats_t stats;
+} onewire_sim_t;
+
+/* Kept outside the bus so the devices can be set up before the thermometer initializes it */
+static onewire_sim_t sims[ONEWIRE_SIM_MAX_BUSES] = {0};
+
+static void onewire_sim_power_on(onewire_sim_t *sim, uint8_t i)
+{
+    static const uint8_t power_on_scratchpad[DS18B20_SCRATCHPAD_SIZE - 1] = {0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10};
+
+    memcpy(sim->scratchpads[i], power_on_scratchpad, sizeof(power_on_scratchpad));
+    sim->scratchpads[i][8] = onewire_crc8(power_on_scratchpad, sizeof(power_on_scratchpad));
+    sim->conversions[i]    = (onewire_sim_conversion_t){0};
+}
+
+static onewire_sim_t *onewire_sim_bus(gpio_num_t pin)
+{
+    onewire_sim_t *sim = NULL;
+
+    for (uint8_t bus = 0; bus < ONEWIRE_SIM_MAX_BUSES; bus++)
+    {
+        if (sims[bus].used && sims[bus].pin == pin)
+        {
+            return &sims[bus];
+        }
+        if (!sims[bus].used && sim == NULL)
+        {
+            sim = &sims[bus];
+        }
+    }
+    if (sim == NULL)
+    {
+        return NULL;
+    }
+
+    *sim = (onewire_sim_t){
+        .used          = true,
+        .pin           = pin,
+        .count         = DS18B20_SIM_DEVICES,
+        .connected     = (uint32_t)((1ull << DS18B20_SIM_DEVICES) - 1),
+        .parasite      = DS18B20_SIM_PARASITE,
+        .bit_error_ppm = DS18B20_SIM_BIT_ERROR_PPM,
+        .state         = ONEWIRE_SIM_DONE,
+    };
+    for (uint8_t i = 0; i < ONEWIRE_SIM_MAX_DEVICES; i++)
+    {
+        /* Serial numbers derived from the pin, so every simulated bus has its own devices */
+        uint8_t rom[8] = {DS18B20_FAMILY_CODE, i + 1, pin, 0x51, 0x4D, 0x00, 0x00};
+        rom[7]         = onewire_crc8(rom, 7);
+        memcpy(sim->roms[i], rom, sizeof(rom));
+
+        sim->temperatures[i] = (int16_t)ONEWIRE_SIM_TEMPERATURE_WAVE;
+        onewire_sim_power_on(sim, i);
+    }
+    return sim;
+}
+
+static uint8_t onewire_sim_error(const onewire_sim_t *sim, uint8_t value)
+{
+    if (sim->bit_error_ppm && esp_random() % 1000000 < sim->bit_error_ppm)
+    {
+        return value ^ 1;
+    }
+    return value;
+}
+
+/* Wired-AND of one bit of every selected device's data */
+static uint8_t onewire_sim_and(const onewire_sim_t *sim, const uint8_t *data, size_t stride, uint8_t bit, bool complement)
+{
+    uint8_t value = 1;
+
+    for (uint8_t i = 0; i < sim->count; i++)
+    {
+        if (sim->selected & sim->connected & (1u << i))
+        {
+            uint8_t device_bit = (data[i * stride + bit / 8] >> (bit % 8)) & 1;
+            value &= complement ? device_bit ^ 1 : device_bit;
+        }
+    }
+    return value;
+}
+
+static void onewire_sim_store(onewire_sim_t *sim, uint8_t i, int16_t raw)
+{
+    uint8_t *scratchpad = sim->scratchpads[i];
+
+    scratchpad[0]                           = raw & 0xFF;
+    scratchpad[1]                           = raw >> 8;
+    scratchpad[DS18B20_SCRATCHPAD_RESERVED] = raw == DS18B20_POWER_ON_RESET_RAW ? DS18B20_POWER_ON_RESET_RESERVED : 0x10 - (raw & 0x0F);
+    scratchpad[8]                           = onewire_crc8(scratchpad, 8);
+}
+
+static void onewire_sim_convert(onewire_sim_t *sim, uint8_t i)
+{
+    uint8_t resolution = ((sim->scratchpads[i][DS18B20_SCRATCHPAD_CONFIG] >> 5) & 0x03) + 9;
+    int32_t value      = sim->temperatures[i];
+
+    if (sim->temperatures[i] == (int16_t)ONEWIRE_SIM_TEMPERATURE_WAVE)
+    {
+        /* A slow 3 °C triangle, every device a bit warmer than the previous one */
+        uint32_t phase_s = esp_timer_get_time() / 1000000 % 600;
+        value            = 2000 + i * 150 + (phase_s < 300 ? phase_s : 600 - phase_s);
+    }
+
+    int16_t raw = value * 16 / 100;
+    raw &= ~((1 << (12 - resolution)) - 1);
+
+    sim->conversions[i] = (onewire_sim_conversion_t){
+        .done_us = esp_timer_get_time() + DS18B20_CONVERSION_TIME_MS(resolution) * 1000,
+        .raw     = raw,
+        .powered = !sim->parasite,
+    };
+    sim->stats.conversions++;
+}
+
+/* Finished conversions land in the scratchpad, a parasite-powered one is lost when the line stopped powering it
+   too early; cut is true when the power goes away now */
+static void onewire_sim_settle(onewire_sim_t *sim, bool cut)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    for (uint8_t i = 0; i < sim->count; i++)
+    {
+        onewire_sim_conversion_t *conversion = &sim->conversions[i];
+        if (conversion->done_us == 0)
+        {
+            continue;
+        }
+
+        if (now_us >= conversion->done_us && conversion->powered)
+        {
+            onewire_sim_store(sim, i, conversion->raw);
+        }
+        else if (now_us >= conversion->done_us || (cut && sim->parasite))
+        {
+            onewire_sim_store(sim, i, DS18B20_POWER_ON_RESET_RAW);
+            sim->stats.conversions_cut++;
+        }
+        else
+        {
+            continue;
+        }
+        conversion->done_us = 0;
+    }
+}
+
+static bool onewire_sim_alarm(const onewire_sim_t *sim, uint8_t i)
+{
+    const uint8_t *scratchpad = sim->scratchpads[i];
+    int16_t degrees           = (int16_t)(scratchpad[0] | scratchpad[1] << 8) >> 4;
+
+    return degrees >= (int8_t)scratchpad[DS18B20_SCRATCHPAD_TH] || degrees <= (int8_t)scratchpad[DS18B20_SCRATCHPAD_TL];
+}
+
+static void onewire_sim_byte(onewire_sim_t *sim, uint8_t byte)
+{
+    switch (sim->state)
+    {
+        case ONEWIRE_SIM_ROM_COMMAND:
+            sim->position     = 0;
+            sim->search_phase = 0;
+            switch (byte)
+            {
+                case ONEWIRE_CMD_SKIP_ROM:
+                    sim->selected = sim->connected;
+                    sim->state    = ONEWIRE_SIM_FUNCTION_COMMAND;
+                    break;
+                case ONEWIRE_CMD_MATCH_ROM:
+                    sim->state = ONEWIRE_SIM_MATCH_ROM;
+                    break;
+                case ONEWIRE_CMD_SEARCH_ROM:
+                case ONEWIRE_CMD_ALARM_SEARCH:
+                    sim->selected = 0;
+                    for (uint8_t i = 0; i < sim->count; i++)
+                    {
+                        if (byte == ONEWIRE_CMD_SEARCH_ROM || onewire_sim_alarm(sim, i))
+                        {
+                            sim->selected |= 1u << i;
+                        }
+                    }
+                    sim->state = ONEWIRE_SIM_SEARCH;
+                    break;
+                default:
+                    sim->state = ONEWIRE_SIM_DONE;
+                    break;
+            }
+            break;
+        case ONEWIRE_SIM_MATCH_ROM:
+            sim->match[sim->position++] = byte;
+            if (sim->position == sizeof(sim->match))
+            {
+                sim->selected = 0;
+                for (uint8_t i = 0; i < sim->count; i++)
+                {
+                    if (memcmp(sim->roms[i], sim->match, sizeof(sim->match)) == 0)
+                    {
+                        sim->selected |= 1u << i;
+                    }
+                }
+                sim->state = ONEWIRE_SIM_FUNCTION_COMMAND;
+            }
+            break;
+        case ONEWIRE_SIM_FUNCTION_COMMAND:
+            sim->position = 0;
+            switch (byte)
+            {
+                case DS18B20_CMD_CONVERT_T:
+                    for (uint8_t i = 0; i < sim->count; i++)
+                    {
+                        if (sim->selected & sim->connected & (1u << i))
+                        {
+                            onewire_sim_convert(sim, i);
+                        }
+                    }
+                    sim->state = ONEWIRE_SIM_DONE;
+                    break;
+                case DS18B20_CMD_WRITE_SCRATCHPAD:
+                    for (uint8_t i = 0; i < sim->count; i++)
+                    {
+                        if (sim->selected & sim->connected & (1u << i))
+                        {
+                            sim->stats.writes++;
+                        }
+                    }
+                    sim->state = ONEWIRE_SIM_WRITE_SCRATCHPAD;
+                    break;
+                case DS18B20_CMD_READ_SCRATCHPAD:
+                    sim->state = ONEWIRE_SIM_READ_SCRATCHPAD;
+                    break;
+                case DS18B20_CMD_READ_POWER_SUPPLY:
+                    sim->state = ONEWIRE_SIM_READ_POWER_SUPPLY;
+                    break;
+                default:
+                    sim->state = ONEWIRE_SIM_DONE;
+                    break;
+            }
+            break;
+        case ONEWIRE_SIM_WRITE_SCRATCHPAD:
+            for (uint8_t i = 0; i < sim->count; i++)
+            {
+                if (sim->selected & sim->connected & (1u << i))
+                {
+                    /* TH, TL and the configuration register, whose unused bits read as ones */
+                    sim->scratchpads[i][DS18B20_SCRATCHPAD_TH + sim->position] = sim->position == 2 ? (byte & 0x60) | 0x1F : byte;
+                    sim->scratchpads[i][8]                                     = onewire_crc8(sim->scratchpads[i], 8);
+                }
+            }
+            if (++sim->position == 3)
+            {
+                sim->state = ONEWIRE_SIM_DONE;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static uint8_t onewire_sim_slot(onewire_sim_t *sim, uint8_t bit)
+{
+    uint8_t value;
+
+    switch (sim->state)
+    {
+        case ONEWIRE_SIM_SEARCH:
+            if (sim->search_phase < 2)
+            {
+                value = onewire_sim_error(sim, onewire_sim_and(sim, sim->roms[0], sizeof(sim->roms[0]), sim->position, sim->search_phase == 1));
+                sim->search_phase++;
+                return value & bit;
+            }
+
+            /* Devices whose ROM bit differs from the chosen direction drop out */
+            for (uint8_t i = 0; i < sim->count; i++)
+            {
+                if (((sim->roms[i][sim->position / 8] >> (sim->position % 8)) & 1) != bit)
+                {
+                    sim->selected &= ~(1u << i);
+                }
+            }
+            sim->search_phase = 0;
+            if (++sim->position == 64)
+            {
+                sim->state = ONEWIRE_SIM_FUNCTION_COMMAND;
+            }
+            return bit;
+        case ONEWIRE_SIM_READ_SCRATCHPAD:
+            if (sim->position == DS18B20_SCRATCHPAD_SIZE * 8)
+            {
+                return bit;
+            }
+            value = onewire_sim_error(sim, onewire_sim_and(sim, sim->scratchpads[0], sizeof(sim->scratchpads[0]), sim->position++, false));
+            return value & bit;
+        case ONEWIRE_SIM_READ_POWER_SUPPLY:
+            return (sim->selected & sim->connected) && sim->parasite ? 0 : bit;
+        case ONEWIRE_SIM_DONE:
+            return bit;
+        default:
+            sim->shift |= bit << sim->bits;
+            if (++sim->bits == 8)
+            {
+                onewire_sim_byte(sim, sim->shift);
+                sim->shift = 0;
+                sim->bits  = 0;
+            }
+            return bit;
+    }
+}
+
+static esp_err_t onewire_sim_init(onewire_bus_t *bus)
+{
+    onewire_sim_t *sim = onewire_sim_bus(bus->pin);
+    if (sim == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    sim->state = ONEWIRE_SIM_DONE;
+    bus->ctx   = sim;
+    return ESP_OK;
+}
+
+static bool onewire_sim_reset(onewire_bus_t *bus)
+{
+    int64_t started_us = esp_timer_get_time();
+    onewire_sim_t *sim = bus->ctx;
+
+    esp_rom_delay_us(ONEWIRE_SIM_RESET_US);
+    onewire_sim_settle(sim, true);
+    sim->state    = ONEWIRE_SIM_ROM_COMMAND;
+    sim->selected = 0;
+    sim->shift    = 0;
+    sim->bits     = 0;
+    bus->stats.cpu_us += esp_timer_get_time() - started_us;
+    return sim->connected != 0;
+}
+
+static uint8_t onewire_sim_touch_bit(onewire_bus_t *bus, uint8_t bit)
+{
+    int64_t started_us = esp_timer_get_time();
+    esp_rom_delay_us(ONEWIRE_SIM_SLOT_US);
+    uint8_t value = onewire_sim_slot(bus->ctx, bit);
+    bus->stats.cpu_us += esp_timer_get_time() - started_us;
+    return value;
+}
+
+static void onewire_sim_write_bytes(onewire_bus_t *bus, const uint8_t *data, uint8_t len)
+{
+    int64_t started_us = esp_timer_get_time();
+    esp_rom_delay_us(len * 8 * ONEWIRE_SIM_SLOT_US);
+    for (uint8_t i = 0; i < len * 8; i++)
+    {
+        onewire_sim_slot(bus->ctx, (data[i / 8] >> (i % 8)) & 1);
+    }
+    bus->stats.cpu_us += esp_timer_get_time() - started_us;
+}
+
+static void onewire_sim_read_bytes(onewire_bus_t *bus, uint8_t *data, uint8_t len)
+{
+    int64_t started_us = esp_timer_get_time();
+    esp_rom_delay_us(len * 8 * ONEWIRE_SIM_SLOT_US);
+    memset(data, 0, len);
+    for (uint8_t i = 0; i < len * 8; i++)
+    {
+        data[i / 8] |= onewire_sim_slot(bus->ctx, 1) << (i % 8);
+    }
+    bus->stats.cpu_us += esp_timer_get_time() - started_us;
+}
+
+static void onewire_sim_strong_pullup(onewire_bus_t *bus, bool enable)
+{
+    onewire_sim_t *sim = bus->ctx;
+
+    if (!enable)
+    {
+        onewire_sim_settle(sim, true);
+        return;
+    }
+    for (uint8_t i = 0; i < sim->count; i++)
+    {
+        sim->conversions[i].powered = true;
+    }
+}
+
+const onewire_backend_t onewire_sim_backend = {
+    .init          = onewire_sim_init,
+    .reset         = onewire_sim_reset,
+    .touch_bit     = onewire_sim_touch_bit,
+    .write_bytes   = onewire_sim_write_bytes,
+    .read_bytes    = onewire_sim_read_bytes,
+    .strong_pullup = onewire_sim_strong_pullup,
+};
+
+void onewire_sim_set_devices(gpio_num_t pin, uint8_t count)
+{
+    onewire_sim_t *sim = onewire_sim_bus(pin);
+    if (sim == NULL)
+    {
+        return;
+    }
+
+    count = count < ONEWIRE_SIM_MAX_DEVICES ? count : ONEWIRE_SIM_MAX_DEVICES;
+    for (uint8_t i = sim->count; i < count; i++)
+    {
+        onewire_sim_power_on(sim, i);
+    }
+    sim->count     = count;
+    sim->connected = (uint32_t)((1ull << count) - 1);
+}
+
+void onewire_sim_connect(gpio_num_t pin, uint8_t device, bool connected)
+{
+    onewire_sim_t *sim = onewire_sim_bus(pin);
+    if (sim == NULL || device >= sim->count)
+    {
+        return;
+    }
+
+    if (connected && !(sim->connected & (1u << device)))
+    {
+        onewire_sim_power_on(sim, device);
+        sim->connected |= 1u << device;
+    }
+    else if (!connected)
+    {
+        sim->connected &= ~(1u << device);
+    }
+}
+
+void onewire_sim_set_temperature(gpio_num_t pin, uint8_t device, int16_t value)
+{
+    onewire_sim_t *sim = onewire_sim_bus(pin);
+    if (sim != NULL && device < ONEWIRE_SIM_MAX_DEVICES)
+    {
+        sim->temperatures[device] = value;
+    }
+}
+
+void onewire_sim_set_parasite(gpio_num_t pin, bool parasite)
+{
+    onewire_sim_t *sim = onewire_sim_bus(pin);
+    if (sim != NULL)
+    {
+        sim->parasite = parasite;
+    }
+}
+
+void onewire_sim_set_bit_error_ppm(gpio_num_t pin, uint32_t ppm)
+{
+    onewire_sim_t *sim = onewire_sim_bus(pin);
+    if (sim != NULL)
+    {
+        sim->bit_error_ppm = ppm;
+    }
+}
+
+const uint8_t *onewire_sim_rom(gpio_num_t pin, uint8_t device)
+{
+    onewire_sim_t *sim = onewire_sim_bus(pin);
+    return sim != NULL && device < ONEWIRE_SIM_MAX_DEVICES ? sim->roms[device] : NULL;
+}
+
+const onewire_sim_stats_t *onewire_sim_get_stats(gpio_num_t pin)
+{
+    onewire_sim_t *sim = onewire_sim_bus(pin);
+    return sim != NULL ? &sim->stats : NULL;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ONEWIRE_SIM_MAX_BUSES 8             /* Simulated buses, told apart by their pin */
+#define ONEWIRE_SIM_MAX_DEVICES 32          /* Devices one simulated bus can carry */
+#define ONEWIRE_SIM_RESET_US 960            /* Reset pulse and presence window */
+#define ONEWIRE_SIM_SLOT_US 65              /* Time slot and its recovery time */
+#define ONEWIRE_SIM_TEMPERATURE_WAVE 0x8000 /* Temperature following the built-in slow triangle */
+
+    typedef struct
+    {
+        uint32_t conversions;     /* Convert T received by a connected device */
+        uint32_t conversions_cut; /* Parasite conversions whose power went away before they were done */
+        uint32_t writes;          /* Write Scratchpad received by a connected device */
+    } onewire_sim_stats_t;
+
+    /* Runtime controls of onewire_sim_backend, they can be called before the bus is initialized.
+       Temperatures are in 0.01 °C, a device reconnected after a disconnect starts from its power-on scratchpad. */
+    void onewire_sim_set_devices(gpio_num_t pin, uint8_t count);
+    void onewire_sim_connect(gpio_num_t pin, uint8_t device, bool connected);
+    void onewire_sim_set_temperature(gpio_num_t pin, uint8_t device, int16_t value);
+    void onewire_sim_set_parasite(gpio_num_t pin, bool parasite);
+    void onewire_sim_set_bit_error_ppm(gpio_num_t pin, uint32_t ppm);
+    const uint8_t *onewire_sim_rom(gpio_num_t pin, uint8_t device);
+    const onewire_sim_stats_t *onewire_sim_get_stats(gpio_num_t pin);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,241 @@
+#include "ota.h"
+
+#include <stdlib.h>
+
+#include "config.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "ota_heatshrink.h"
+
+static const char *TAG = "ota.c";
+
+/* Sub-element header of the Zigbee OTA file: 16-bit tag and 32-bit length, little-endian */
+#define OTA_ELEMENT_HEADER_SIZE 6
+
+typedef struct
+{
+    const esp_partition_t *partition;
+    esp_ota_handle_t handle;
+    ota_heatshrink_t *decoder; /* Only allocated while a compressed element is received */
+    uint8_t header[OTA_ELEMENT_HEADER_SIZE];
+    uint8_t header_len;
+    uint16_t tag;
+    uint32_t remaining; /* Bytes left in the current element */
+    bool image_complete;
+    int64_t start_us;
+} ota_upgrade_t;
+
+static ota_upgrade_t upgrade = {0};
+static ota_stats_t ota_stats = {0};
+
+void ota_add_cluster(esp_zb_cluster_list_t *cluster_list)
+{
+    esp_zb_ota_cluster_cfg_t ota_cluster_cfg = {
+        .ota_upgrade_file_version        = ZB_OTA_FILE_VERSION,
+        .ota_upgrade_downloaded_file_ver = ZB_OTA_FILE_VERSION,
+        .ota_upgrade_manufacturer        = ZB_MANUFACTURER_CODE,
+        .ota_upgrade_image_type          = ZB_OTA_IMAGE_TYPE,
+    };
+    esp_zb_attribute_list_t *ota_cluster = esp_zb_ota_cluster_create(&ota_cluster_cfg);
+
+    esp_zb_zcl_ota_upgrade_client_variable_t variable_config = {
+        .timer_query   = ESP_ZB_ZCL_OTA_UPGRADE_QUERY_TIMER_COUNT_DEF,
+        .hw_version    = ZB_OTA_HW_VERSION,
+        .max_data_size = ZB_OTA_MAX_DATA_SIZE,
+    };
+    uint16_t server_addr = 0xffff;
+    uint8_t server_ep    = 0xff;
+    ESP_ERROR_CHECK(esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID, &variable_config));
+    ESP_ERROR_CHECK(esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID, &server_addr));
+    ESP_ERROR_CHECK(esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID, &server_ep));
+    ESP_ERROR_CHECK(esp_zb_cluster_list_add_ota_cluster(cluster_list, ota_cluster, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE));
+}
+
+static void ota_cleanup(void)
+{
+    if (upgrade.handle)
+    {
+        esp_ota_abort(upgrade.handle);
+    }
+    free(upgrade.decoder);
+    upgrade = (ota_upgrade_t){0};
+}
+
+static bool ota_write(void *ctx, const uint8_t *data, size_t len)
+{
+    esp_err_t err = esp_ota_write(upgrade.handle, data, len);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to write OTA partition (status: %s)", esp_err_to_name(err));
+        return false;
+    }
+    ota_stats.bytes_written += len;
+    return true;
+}
+
+static esp_err_t ota_element_start(void)
+{
+    upgrade.tag       = upgrade.header[0] | upgrade.header[1] << 8;
+    upgrade.remaining = upgrade.header[2] | upgrade.header[3] << 8 | upgrade.header[4] << 16 | (uint32_t)upgrade.header[5] << 24;
+    ESP_LOGI(TAG, "OTA element 0x%04x, %lu bytes", upgrade.tag, upgrade.remaining);
+
+    if (upgrade.tag == OTA_TAG_UPGRADE_IMAGE || upgrade.tag == OTA_TAG_HEATSHRINK_IMAGE)
+    {
+        ESP_RETURN_ON_FALSE(!upgrade.image_complete, ESP_ERR_INVALID_STATE, TAG, "OTA file carries more than one image");
+    }
+    if (upgrade.tag == OTA_TAG_HEATSHRINK_IMAGE)
+    {
+        upgrade.decoder = malloc(sizeof(ota_heatshrink_t));
+        ESP_RETURN_ON_FALSE(upgrade.decoder, ESP_ERR_NO_MEM, TAG, "No memory for the OTA decoder");
+        ota_heatshrink_init(upgrade.decoder, ota_write, NULL);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ota_element_end(void)
+{
+    if (upgrade.tag == OTA_TAG_HEATSHRINK_IMAGE)
+    {
+        bool finished = ota_heatshrink_finish(upgrade.decoder);
+        free(upgrade.decoder);
+        upgrade.decoder = NULL;
+        ESP_RETURN_ON_FALSE(finished, ESP_FAIL, TAG, "Failed to decompress OTA image");
+    }
+    if (upgrade.tag == OTA_TAG_UPGRADE_IMAGE || upgrade.tag == OTA_TAG_HEATSHRINK_IMAGE)
+    {
+        upgrade.image_complete = true;
+    }
+    upgrade.header_len = 0;
+    return ESP_OK;
+}
+
+/* Image Block payloads split the file anywhere, element headers included. Elements other than the image,
+   e.g. signatures and certificates, are skipped. */
+static esp_err_t ota_receive(const uint8_t *data, uint16_t len)
+{
+    ota_stats.bytes_on_air += len;
+
+    while (len > 0)
+    {
+        if (upgrade.header_len < OTA_ELEMENT_HEADER_SIZE)
+        {
+            upgrade.header[upgrade.header_len++] = *data++;
+            len--;
+            if (upgrade.header_len == OTA_ELEMENT_HEADER_SIZE)
+            {
+                ESP_RETURN_ON_ERROR(ota_element_start(), TAG, "Unsupported OTA element");
+                if (upgrade.remaining == 0)
+                {
+                    ESP_RETURN_ON_ERROR(ota_element_end(), TAG, "Failed to finish OTA element");
+                }
+            }
+            continue;
+        }
+
+        uint16_t chunk = len < upgrade.remaining ? len : (uint16_t)upgrade.remaining;
+        switch (upgrade.tag)
+        {
+            case OTA_TAG_UPGRADE_IMAGE:
+                ESP_RETURN_ON_FALSE(ota_write(NULL, data, chunk), ESP_FAIL, TAG, "Failed to store OTA image");
+                break;
+            case OTA_TAG_HEATSHRINK_IMAGE:
+                ESP_RETURN_ON_FALSE(ota_heatshrink_feed(upgrade.decoder, data, chunk), ESP_FAIL, TAG, "Failed to decompress OTA image");
+                break;
+            default:
+                break;
+        }
+        data += chunk;
+        len -= chunk;
+        upgrade.remaining -= chunk;
+
+        if (upgrade.remaining == 0)
+        {
+            ESP_RETURN_ON_ERROR(ota_element_end(), TAG, "Failed to finish OTA element");
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t ota_handle_upgrade(const esp_zb_zcl_ota_upgrade_value_message_t *message)
+{
+    esp_err_t ret = ESP_OK;
+
+    ESP_RETURN_ON_FALSE(message->info.status == ESP_ZB_ZCL_STATUS_SUCCESS, ESP_ERR_INVALID_ARG, TAG, "OTA upgrade error status(%d)", message->info.status);
+
+    switch (message->upgrade_status)
+    {
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START:
+            ESP_LOGI(TAG, "OTA upgrade to file version 0x%08lx, %lu bytes", message->ota_header.file_version, message->ota_header.image_size);
+            ota_cleanup();
+            ota_stats         = (ota_stats_t){0};
+            upgrade.start_us  = esp_timer_get_time();
+            upgrade.partition = esp_ota_get_next_update_partition(NULL);
+            ESP_RETURN_ON_FALSE(upgrade.partition, ESP_ERR_NOT_FOUND, TAG, "No OTA partition");
+            ESP_RETURN_ON_ERROR(esp_ota_begin(upgrade.partition, OTA_WITH_SEQUENTIAL_WRITES, &upgrade.handle), TAG, "Failed to begin OTA partition");
+            break;
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE:
+            ESP_RETURN_ON_FALSE(upgrade.handle, ESP_ERR_INVALID_STATE, TAG, "OTA data without a started upgrade");
+            if (message->payload_size && message->payload)
+            {
+                ret = ota_receive(message->payload, message->payload_size);
+            }
+            ESP_LOGD(TAG, "OTA progress: %lu/%lu", ota_stats.bytes_on_air, message->ota_header.image_size);
+            break;
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY:
+            ESP_LOGI(TAG, "OTA upgrade apply");
+            break;
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK:
+            ota_stats.duration_ms = (esp_timer_get_time() - upgrade.start_us) / 1000;
+            ESP_LOGI(
+                TAG,
+                "OTA image received in %lu ms: %lu bytes on air, %lu bytes written (%lu%%)",
+                ota_stats.duration_ms,
+                ota_stats.bytes_on_air,
+                ota_stats.bytes_written,
+                ota_stats.bytes_written ? (uint32_t)((uint64_t)ota_stats.bytes_on_air * 100 / ota_stats.bytes_written) : 0);
+            if (!upgrade.image_complete || upgrade.header_len != 0)
+            {
+                ESP_LOGE(TAG, "OTA image is incomplete");
+                ret = ESP_FAIL;
+            }
+            break;
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH:
+            ESP_LOGI(TAG, "OTA upgrade finished, restarting");
+            ret            = esp_ota_end(upgrade.handle);
+            upgrade.handle = 0;
+            ESP_RETURN_ON_ERROR(ret, TAG, "OTA image is invalid");
+            ESP_RETURN_ON_ERROR(esp_ota_set_boot_partition(upgrade.partition), TAG, "Failed to set the boot partition");
+            esp_restart();
+            break;
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT:
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR:
+            ESP_LOGW(TAG, "OTA upgrade aborted after %lu bytes", ota_stats.bytes_on_air);
+            ota_cleanup();
+            break;
+        default:
+            ESP_LOGI(TAG, "OTA status: %d", message->upgrade_status);
+            break;
+    }
+
+    if (ret != ESP_OK)
+    {
+        ota_cleanup();
+    }
+    return ret;
+}
+
+/* A new image boots pending verification with rollback enabled, joining the network proves it works */
+void ota_confirm_image(void)
+{
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK && state == ESP_OTA_IMG_PENDING_VERIFY)
+    {
+        ESP_LOGI(TAG, "New firmware joined the network, cancelling the rollback");
+        esp_ota_mark_app_valid_cancel_rollback();
+    }
+}
+
+const ota_stats_t *ota_get_stats(void) { return &ota_stats; }
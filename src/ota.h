@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define OTA_TAG_UPGRADE_IMAGE 0x0000      /* Plain application image */
+#define OTA_TAG_HEATSHRINK_IMAGE 0xF000   /* Manufacturer-specific: application image compressed with heatshrink -w 12 -l 4 */
+
+    typedef struct
+    {
+        uint32_t bytes_on_air;  /* Image Block payload received, element headers included */
+        uint32_t bytes_written; /* Application image bytes written to the OTA partition */
+        uint32_t duration_ms;   /* First to last block */
+    } ota_stats_t;
+
+    void ota_add_cluster(esp_zb_cluster_list_t *cluster_list);
+    esp_err_t ota_handle_upgrade(const esp_zb_zcl_ota_upgrade_value_message_t *message);
+    void ota_confirm_image(void);
+    const ota_stats_t *ota_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
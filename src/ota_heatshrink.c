@@ -0,0 +1,96 @@
+#include "ota_heatshrink.h"
+
+#include <string.h>
+
+/* heatshrink bit stream, MSB first: a 1 tag is followed by an 8-bit literal, a 0 tag by a back-reference of
+   WINDOW_BITS offset - 1 and LOOKAHEAD_BITS length - 1. The window starts zeroed, as in the reference decoder. */
+enum
+{
+    OTA_HEATSHRINK_TAG,
+    OTA_HEATSHRINK_LITERAL,
+    OTA_HEATSHRINK_INDEX,
+    OTA_HEATSHRINK_COUNT,
+};
+
+static const uint8_t state_bits[] = {
+    [OTA_HEATSHRINK_TAG]     = 1,
+    [OTA_HEATSHRINK_LITERAL] = 8,
+    [OTA_HEATSHRINK_INDEX]   = OTA_HEATSHRINK_WINDOW_BITS,
+    [OTA_HEATSHRINK_COUNT]   = OTA_HEATSHRINK_LOOKAHEAD_BITS,
+};
+
+#define OTA_HEATSHRINK_WINDOW_MASK ((1u << OTA_HEATSHRINK_WINDOW_BITS) - 1)
+
+void ota_heatshrink_init(ota_heatshrink_t *hs, ota_heatshrink_sink_t sink, void *ctx)
+{
+    memset(hs, 0, sizeof(ota_heatshrink_t));
+    hs->state = OTA_HEATSHRINK_TAG;
+    hs->sink  = sink;
+    hs->ctx   = ctx;
+}
+
+static bool ota_heatshrink_flush(ota_heatshrink_t *hs)
+{
+    if (hs->output_len == 0)
+    {
+        return true;
+    }
+
+    uint16_t len    = hs->output_len;
+    hs->output_len = 0;
+    return hs->sink(hs->ctx, hs->output, len);
+}
+
+static bool ota_heatshrink_emit(ota_heatshrink_t *hs, uint8_t byte)
+{
+    hs->window[hs->head++ & OTA_HEATSHRINK_WINDOW_MASK] = byte;
+    hs->output[hs->output_len++]                         = byte;
+    return hs->output_len < OTA_HEATSHRINK_OUTPUT_SIZE || ota_heatshrink_flush(hs);
+}
+
+bool ota_heatshrink_feed(ota_heatshrink_t *hs, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        hs->bits = hs->bits << 8 | data[i];
+        hs->bit_count += 8;
+
+        while (hs->bit_count >= state_bits[hs->state])
+        {
+            hs->bit_count -= state_bits[hs->state];
+            uint16_t value = (hs->bits >> hs->bit_count) & ((1u << state_bits[hs->state]) - 1);
+
+            switch (hs->state)
+            {
+                case OTA_HEATSHRINK_TAG:
+                    hs->state = value ? OTA_HEATSHRINK_LITERAL : OTA_HEATSHRINK_INDEX;
+                    break;
+                case OTA_HEATSHRINK_LITERAL:
+                    if (!ota_heatshrink_emit(hs, (uint8_t)value))
+                    {
+                        return false;
+                    }
+                    hs->state = OTA_HEATSHRINK_TAG;
+                    break;
+                case OTA_HEATSHRINK_INDEX:
+                    hs->index = value + 1;
+                    hs->state = OTA_HEATSHRINK_COUNT;
+                    break;
+                case OTA_HEATSHRINK_COUNT:
+                    for (uint16_t n = 0; n <= value; n++)
+                    {
+                        if (!ota_heatshrink_emit(hs, hs->window[(hs->head - hs->index) & OTA_HEATSHRINK_WINDOW_MASK]))
+                        {
+                            return false;
+                        }
+                    }
+                    hs->state = OTA_HEATSHRINK_TAG;
+                    break;
+            }
+        }
+    }
+    return true;
+}
+
+/* The encoder pads the last byte with zero bits, a symbol cut short by the end of input is padding */
+bool ota_heatshrink_finish(ota_heatshrink_t *hs) { return ota_heatshrink_flush(hs); }
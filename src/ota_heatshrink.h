@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Parameters the image has to be compressed with: heatshrink -e -w 12 -l 4 */
+#define OTA_HEATSHRINK_WINDOW_BITS 12
+#define OTA_HEATSHRINK_LOOKAHEAD_BITS 4
+#define OTA_HEATSHRINK_OUTPUT_SIZE 256 /* Decompressed bytes handed to the sink at once */
+
+    /* Receives decompressed data, returning false stops the decoder */
+    typedef bool (*ota_heatshrink_sink_t)(void *ctx, const uint8_t *data, size_t len);
+
+    /* Streaming decoder, the whole state including the window fits in about 4.4 kB. Kept free of IDF headers
+       so it builds on a host. */
+    typedef struct
+    {
+        uint8_t window[1 << OTA_HEATSHRINK_WINDOW_BITS];
+        uint8_t output[OTA_HEATSHRINK_OUTPUT_SIZE];
+        uint16_t output_len;
+        uint32_t head;     /* Decompressed bytes so far, the window position is head masked */
+        uint32_t bits;     /* Input bits not consumed yet, the oldest is the most significant */
+        uint8_t bit_count; /* Valid bits in bits */
+        uint8_t state;
+        uint16_t index; /* Back-reference offset while its count is pending */
+        ota_heatshrink_sink_t sink;
+        void *ctx;
+    } ota_heatshrink_t;
+
+    void ota_heatshrink_init(ota_heatshrink_t *hs, ota_heatshrink_sink_t sink, void *ctx);
+    bool ota_heatshrink_feed(ota_heatshrink_t *hs, const uint8_t *data, size_t len);
+    bool ota_heatshrink_finish(ota_heatshrink_t *hs);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,189 @@
+#include "packed_report.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "config.h"
+#include "esp_log.h"
+#include "rom_map.h"
+
+static const char *TAG = "packed_report.c";
+
+/*
+ * Frame layout (octet string payload):
+ *   [0]    sequence number
+ *   [1]    flags, bit 0 set for a key frame
+ *   [2..]  entries: endpoint, then the value
+ *          key frame   - int16 little endian, 0x8000 for unknown
+ *          delta frame - zigzag varint of the difference to the last reported value
+ * A key frame carries every sensor and is sent periodically and whenever a sensor
+ * enters or leaves the unknown state; a delta frame carries only changed sensors.
+ */
+#define PACKED_REPORT_MAX_PAYLOAD 253
+#define PACKED_REPORT_FLAG_KEY_FRAME 0x01
+#define PACKED_REPORT_HEADER_SIZE 2
+#define PACKED_REPORT_MAX_ENTRY_SIZE 4 /* endpoint + zigzag varint of a 16-bit difference */
+#define PACKED_REPORT_UNKNOWN ((int16_t)0x8000)
+
+typedef struct
+{
+    int16_t current;
+    int16_t reported;
+    bool present;
+} packed_report_entry_t;
+
+static packed_report_entry_t entries[ROM_MAP_MAX_SLOTS] = {0};
+static uint8_t frame[PACKED_REPORT_MAX_PAYLOAD + 1]      = {0}; /* ZCL octet string, first byte is the length */
+static uint8_t rom_table[PACKED_REPORT_MAX_PAYLOAD + 1]  = {0};
+static uint8_t sequence                                  = 0;
+static uint8_t frames_since_key_frame                    = DS18B20_PACKED_REPORT_KEY_FRAME_INTERVAL;
+static packed_report_stats_t packed_report_stats         = {0};
+
+static uint8_t zigzag_varint_encode(int32_t value, uint8_t *out)
+{
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    uint8_t size    = 0;
+
+    do
+    {
+        out[size] = zigzag & 0x7F;
+        zigzag >>= 7;
+        if (zigzag)
+        {
+            out[size] |= 0x80;
+        }
+        size++;
+    } while (zigzag);
+
+    return size;
+}
+
+void packed_report_add_cluster(esp_zb_cluster_list_t *cluster_list, const uint8_t *table, uint8_t table_size)
+{
+    if (table_size > PACKED_REPORT_MAX_PAYLOAD)
+    {
+        table_size = PACKED_REPORT_MAX_PAYLOAD;
+    }
+    rom_table[0] = table_size;
+    memcpy(&rom_table[1], table, table_size);
+
+    esp_zb_attribute_list_t *attr_list = esp_zb_zcl_attr_list_create(PACKED_REPORT_CLUSTER_ID);
+    esp_zb_custom_cluster_add_custom_attr(
+        attr_list, PACKED_REPORT_ATTR_VALUES_ID, ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, frame);
+    esp_zb_custom_cluster_add_custom_attr(attr_list, PACKED_REPORT_ATTR_ROM_TABLE_ID, ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, rom_table);
+    esp_zb_cluster_list_add_custom_cluster(cluster_list, attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+void packed_report_add(uint8_t ep, int16_t value)
+{
+    packed_report_entry_t *entry = &entries[ep - DS18B20_FIRST_ENDPOINT];
+
+    if (!entry->present)
+    {
+        entry->present  = true;
+        entry->reported = PACKED_REPORT_UNKNOWN;
+    }
+    entry->current = value;
+}
+
+static void packed_report_flush(uint8_t src_ep, uint8_t size)
+{
+    frame[0] = size;
+
+    esp_zb_zcl_status_t status =
+        esp_zb_zcl_set_attribute_val(src_ep, PACKED_REPORT_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, PACKED_REPORT_ATTR_VALUES_ID, frame, false);
+    if (status != ESP_ZB_ZCL_STATUS_SUCCESS)
+    {
+        ESP_LOGW(TAG, "Failed to update packed report attribute, status: %d", status);
+        return;
+    }
+
+    esp_zb_zcl_report_attr_cmd_t report_attr_cmd = {
+        .zcl_basic_cmd.src_endpoint = src_ep,
+        .address_mode               = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT,
+        .clusterID                  = PACKED_REPORT_CLUSTER_ID,
+        .attributeID                = PACKED_REPORT_ATTR_VALUES_ID,
+        .direction                  = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
+    };
+    esp_zb_zcl_report_attr_cmd_req(&report_attr_cmd);
+
+    packed_report_stats.frames++;
+    packed_report_stats.bytes += size;
+}
+
+void packed_report_send(uint8_t src_ep)
+{
+    bool key_frame = frames_since_key_frame >= DS18B20_PACKED_REPORT_KEY_FRAME_INTERVAL;
+    bool changed   = false;
+
+    for (uint16_t i = 0; i < ROM_MAP_MAX_SLOTS; i++)
+    {
+        packed_report_entry_t *entry = &entries[i];
+        if (!entry->present || entry->current == entry->reported)
+        {
+            continue;
+        }
+
+        changed = true;
+        if (entry->current == PACKED_REPORT_UNKNOWN || entry->reported == PACKED_REPORT_UNKNOWN)
+        {
+            key_frame = true;
+        }
+    }
+
+    if (!changed && !key_frame)
+    {
+        return;
+    }
+
+    uint8_t size = PACKED_REPORT_HEADER_SIZE;
+    for (uint16_t i = 0; i < ROM_MAP_MAX_SLOTS; i++)
+    {
+        packed_report_entry_t *entry = &entries[i];
+        if (!entry->present || (!key_frame && entry->current == entry->reported))
+        {
+            continue;
+        }
+
+        if (size + PACKED_REPORT_MAX_ENTRY_SIZE > PACKED_REPORT_MAX_PAYLOAD)
+        {
+            packed_report_flush(src_ep, size);
+            size = PACKED_REPORT_HEADER_SIZE;
+        }
+
+        if (size == PACKED_REPORT_HEADER_SIZE)
+        {
+            frame[1] = sequence++;
+            frame[2] = key_frame ? PACKED_REPORT_FLAG_KEY_FRAME : 0;
+        }
+
+        frame[1 + size++] = i + DS18B20_FIRST_ENDPOINT;
+        if (key_frame)
+        {
+            frame[1 + size++] = (uint16_t)entry->current & 0xFF;
+            frame[1 + size++] = (uint16_t)entry->current >> 8;
+        }
+        else
+        {
+            size += zigzag_varint_encode((int32_t)entry->current - entry->reported, &frame[1 + size]);
+        }
+
+        if (entry->current != entry->reported)
+        {
+            packed_report_stats.single_reports++;
+        }
+        entry->reported = entry->current;
+    }
+
+    packed_report_flush(src_ep, size);
+    frames_since_key_frame = key_frame ? 0 : frames_since_key_frame + 1;
+
+    ESP_LOGD(
+        TAG,
+        "Packed report totals: %lu frames, %lu bytes, %lu per-endpoint reports replaced",
+        packed_report_stats.frames,
+        packed_report_stats.bytes,
+        packed_report_stats.single_reports);
+}
+
+const packed_report_stats_t *packed_report_get_stats(void) { return &packed_report_stats; }
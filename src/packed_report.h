@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define PACKED_REPORT_CLUSTER_ID 0xFC00      /* Manufacturer-specific cluster carrying all readings in one attribute */
+#define PACKED_REPORT_ATTR_VALUES_ID 0x0000  /* Octet string: packed readings, see packed_report.c for the layout */
+#define PACKED_REPORT_ATTR_ROM_TABLE_ID 0x0001 /* Octet string: endpoint followed by 6-byte ROM serial for each sensor */
+#define PACKED_REPORT_ROM_TABLE_ENTRIES 36     /* Sensors that fit into the ROM table attribute */
+
+    typedef struct
+    {
+        uint32_t frames;         /* Packed frames sent */
+        uint32_t bytes;          /* Packed payload bytes sent */
+        uint32_t single_reports; /* Per-endpoint reports the same changes would have needed */
+    } packed_report_stats_t;
+
+    void packed_report_add_cluster(esp_zb_cluster_list_t *cluster_list, const uint8_t *rom_table, uint8_t rom_table_size);
+    void packed_report_add(uint8_t ep, int16_t value);
+    void packed_report_send(uint8_t src_ep);
+    const packed_report_stats_t *packed_report_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+#include "power.h"
+
+#include "config.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+
+static const char *TAG = "power.c";
+
+static int64_t cycle_started_us  = 0;
+static int64_t cycle_sleep_us    = 0;
+static power_stats_t power_stats = {0};
+
+esp_err_t power_init(void)
+{
+#if ZB_SLEEPY_END_DEVICE
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz       = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz       = CONFIG_XTAL_FREQ,
+        .light_sleep_enable = true,
+    };
+    ESP_RETURN_ON_ERROR(esp_pm_configure(&pm_config), TAG, "Failed to configure power management");
+#else
+    ESP_LOGW(TAG, "CONFIG_PM_ENABLE is not set, the device will not enter light sleep");
+#endif
+    esp_zb_sleep_enable(true);
+#endif
+    cycle_started_us = esp_timer_get_time();
+    return ESP_OK;
+}
+
+/* Called between esp_zb_init() and esp_zb_start(): the device joins with rx off when idle, so the parent keeps
+   frames for it until it polls instead of sending them right away */
+void power_configure_stack(void)
+{
+#if ZB_SLEEPY_END_DEVICE
+    esp_zb_set_rx_on_when_idle(false);
+#endif
+}
+
+/* A sleepy end device polls its parent once per measurement cycle, frames queued for it wait at most that long */
+void power_set_poll_interval(uint32_t interval_ms)
+{
+#if ZB_SLEEPY_END_DEVICE
+    esp_zb_zdo_pim_set_long_poll_interval(interval_ms);
+    ESP_LOGI(TAG, "Parent poll interval set to %lu ms", interval_ms);
+#endif
+}
+
+/* Called on ESP_ZB_COMMON_SIGNAL_CAN_SLEEP, returns after wake-up */
+void power_sleep(void)
+{
+    int64_t started_us = esp_timer_get_time();
+    esp_zb_sleep_now();
+    cycle_sleep_us += esp_timer_get_time() - started_us;
+}
+
+void power_cycle_end(void)
+{
+    int64_t now_us   = esp_timer_get_time();
+    int64_t cycle_us = now_us - cycle_started_us;
+
+    if (cycle_us <= 0)
+    {
+        return;
+    }
+
+    power_stats.sleep_us      = cycle_sleep_us;
+    power_stats.awake_us      = cycle_us - cycle_sleep_us;
+    power_stats.duty_permille = power_stats.awake_us * 1000 / cycle_us;
+    /* uA * us / 3600 = pAh, divided by 1000 for nAh */
+    power_stats.charge_nah = ((uint64_t)power_stats.awake_us * POWER_ACTIVE_CURRENT_UA + (uint64_t)power_stats.sleep_us * POWER_SLEEP_CURRENT_UA) / 3600000;
+
+    ESP_LOGD(
+        TAG,
+        "Cycle awake %lu us, asleep %lu us, duty %u.%u%%, about %lu nAh",
+        power_stats.awake_us,
+        power_stats.sleep_us,
+        power_stats.duty_permille / 10,
+        power_stats.duty_permille % 10,
+        power_stats.charge_nah);
+
+    cycle_started_us = now_us;
+    cycle_sleep_us   = 0;
+}
+
+const power_stats_t *power_get_stats(void) { return &power_stats; }
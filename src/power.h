@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        uint32_t awake_us;      /* Time awake during the last measurement cycle */
+        uint32_t sleep_us;      /* Time in light sleep during the last measurement cycle */
+        uint16_t duty_permille; /* Awake share of the last cycle */
+        uint32_t charge_nah;    /* Estimated charge drawn in the last cycle, nAh */
+    } power_stats_t;
+
+    esp_err_t power_init(void);
+    void power_configure_stack(void);
+    void power_set_poll_interval(uint32_t interval_ms);
+    void power_sleep(void);
+    void power_cycle_end(void);
+    const power_stats_t *power_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,99 @@
+#include "reading_filter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_cpu.h"
+
+/*
+ * Integer-only pipeline, applied in this order:
+ *   spike rejector - drops a sample further than spike_threshold from the last accepted one,
+ *                    unless READING_FILTER_SPIKE_MAX_REJECTS samples in a row were dropped
+ *   median of N    - over the last median_size accepted samples
+ *   EMA            - ema += (x - ema) / 2^ema_shift in 24.8 fixed point
+ */
+
+static reading_filter_stats_t reading_filter_stats = {0};
+
+void reading_filter_reset(reading_filter_t *filter) { memset(filter, 0, sizeof(reading_filter_t)); }
+
+static int16_t reading_filter_median(reading_filter_t *filter, uint8_t size, int16_t value)
+{
+    if (size > READING_FILTER_MEDIAN_MAX)
+    {
+        size = READING_FILTER_MEDIAN_MAX;
+    }
+
+    filter->window[filter->next] = value;
+    filter->next                 = (filter->next + 1) % size;
+    if (filter->count < size)
+    {
+        filter->count++;
+    }
+
+    /* Insertion sort of at most five values beats anything cleverer */
+    int16_t sorted[READING_FILTER_MEDIAN_MAX];
+    for (uint8_t i = 0; i < filter->count; i++)
+    {
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > filter->window[i])
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = filter->window[i];
+    }
+    return sorted[filter->count / 2];
+}
+
+/* Returns false when the sample was rejected as a spike and *value is left untouched */
+bool reading_filter_apply(reading_filter_t *filter, const reading_filter_config_t *config, int16_t *value)
+{
+    uint32_t started_cycles = esp_cpu_get_cycle_count();
+    bool primed             = filter->count > 0;
+    int16_t sample          = *value;
+
+    reading_filter_stats.samples++;
+
+    if (primed && config->spike_threshold > 0 && abs(sample - filter->last) > config->spike_threshold &&
+        filter->rejected < READING_FILTER_SPIKE_MAX_REJECTS)
+    {
+        filter->rejected++;
+        reading_filter_stats.spikes_rejected++;
+        reading_filter_stats.cpu_cycles += esp_cpu_get_cycle_count() - started_cycles;
+        return false;
+    }
+    filter->rejected = 0;
+    filter->last     = sample;
+
+    int16_t filtered = config->median_size > 1 ? reading_filter_median(filter, config->median_size, sample) : sample;
+    if (config->median_size <= 1)
+    {
+        filter->count = 1;
+    }
+
+    if (config->ema_shift > 0)
+    {
+        if (!primed)
+        {
+            filter->ema = (int32_t)filtered << 8;
+        }
+        else
+        {
+            filter->ema += (((int32_t)filtered << 8) - filter->ema) >> config->ema_shift;
+        }
+        filtered = (int16_t)((filter->ema + 0x80) >> 8);
+    }
+
+    if (primed && filtered == filter->output && sample != filter->output)
+    {
+        reading_filter_stats.changes_suppressed++;
+    }
+    filter->output = filtered;
+    *value         = filtered;
+
+    reading_filter_stats.cpu_cycles += esp_cpu_get_cycle_count() - started_cycles;
+    return true;
+}
+
+const reading_filter_stats_t *reading_filter_get_stats(void) { return &reading_filter_stats; }
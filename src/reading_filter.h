@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define READING_FILTER_MEDIAN_MAX 5        /* Longest median window */
+#define READING_FILTER_EMA_SHIFT_MAX 4     /* Smallest EMA weight is 1/16 */
+#define READING_FILTER_SPIKE_MAX_REJECTS 2 /* A step that persists longer than this is accepted as real */
+
+    typedef struct
+    {
+        uint8_t median_size;      /* 1 disables the median */
+        uint8_t ema_shift;        /* EMA weight 1/2^shift, 0 disables the EMA */
+        uint16_t spike_threshold; /* Largest accepted step in 0.01 °C, 0 disables the spike rejector */
+    } reading_filter_config_t;
+
+    /* State only, the configuration is kept with the sensor */
+    typedef struct
+    {
+        int16_t window[READING_FILTER_MEDIAN_MAX];
+        int16_t last;     /* Last sample that passed the spike rejector */
+        int16_t output;   /* Last filtered value */
+        int32_t ema;      /* 24.8 fixed point */
+        uint8_t count;    /* Samples in the window, 0 until primed */
+        uint8_t next;     /* Ring position of the next sample */
+        uint8_t rejected; /* Consecutive rejected spikes */
+    } reading_filter_t;
+
+    typedef struct
+    {
+        uint32_t samples;            /* Samples filtered */
+        uint32_t cpu_cycles;         /* CPU cycles spent filtering */
+        uint32_t spikes_rejected;    /* Samples dropped by the spike rejector */
+        uint32_t changes_suppressed; /* Raw changes that left the filtered value unchanged */
+    } reading_filter_stats_t;
+
+    void reading_filter_reset(reading_filter_t *filter);
+    bool reading_filter_apply(reading_filter_t *filter, const reading_filter_config_t *config, int16_t *value);
+    const reading_filter_stats_t *reading_filter_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+#include "rom_map.h"
+
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "rom_map.c";
+
+#define ROM_MAP_NAMESPACE "thermometer"
+#define ROM_MAP_KEY "rom_map"
+
+static const ds18b20_phy_addr_t free_slot = {0};
+
+esp_err_t rom_map_load(rom_map_t *map)
+{
+    nvs_handle_t handle;
+
+    memset(map, 0, sizeof(rom_map_t));
+
+    esp_err_t ret = nvs_open(ROM_MAP_NAMESPACE, NVS_READONLY, &handle);
+    if (ret == ESP_ERR_NVS_NOT_FOUND)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to open NVS namespace");
+
+    size_t size = sizeof(map->slots);
+    ret         = nvs_get_blob(handle, ROM_MAP_KEY, map->slots, &size);
+    nvs_close(handle);
+
+    if (ret == ESP_ERR_NVS_NOT_FOUND)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to read ROM map");
+    ESP_RETURN_ON_FALSE(size % sizeof(ds18b20_phy_addr_t) == 0, ESP_ERR_INVALID_SIZE, TAG, "Corrupted ROM map (size %u)", size);
+
+    map->count = size / sizeof(ds18b20_phy_addr_t);
+    return ESP_OK;
+}
+
+esp_err_t rom_map_save(const rom_map_t *map)
+{
+    nvs_handle_t handle;
+
+    ESP_RETURN_ON_ERROR(nvs_open(ROM_MAP_NAMESPACE, NVS_READWRITE, &handle), TAG, "Failed to open NVS namespace");
+
+    esp_err_t ret = nvs_set_blob(handle, ROM_MAP_KEY, map->slots, map->count * sizeof(ds18b20_phy_addr_t));
+    if (ret == ESP_OK)
+    {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to write ROM map");
+    return ESP_OK;
+}
+
+bool rom_map_slot_is_free(const rom_map_t *map, uint8_t slot) { return memcmp(map->slots[slot], free_slot, sizeof(ds18b20_phy_addr_t)) == 0; }
+
+int rom_map_find(const rom_map_t *map, const ds18b20_phy_addr_t addr)
+{
+    for (uint8_t slot = 0; slot < map->count; slot++)
+    {
+        if (memcmp(map->slots[slot], addr, sizeof(ds18b20_phy_addr_t)) == 0)
+        {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+int rom_map_allocate(rom_map_t *map, const ds18b20_phy_addr_t addr)
+{
+    for (uint16_t slot = 0; slot < ROM_MAP_MAX_SLOTS; slot++)
+    {
+        if (slot >= map->count || rom_map_slot_is_free(map, slot))
+        {
+            memcpy(map->slots[slot], addr, sizeof(ds18b20_phy_addr_t));
+            if (slot >= map->count)
+            {
+                map->count = slot + 1;
+            }
+            return slot;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ROM_MAP_MAX_SLOTS (241 - DS18B20_FIRST_ENDPOINT) /* Endpoint slots up to the Zigbee application endpoint limit of 240 */
+
+    typedef uint8_t ds18b20_phy_addr_t[8];
+
+    /* Slot i holds the ROM of the sensor bound to endpoint i + DS18B20_FIRST_ENDPOINT, all-zero ROM marks a free slot */
+    typedef struct
+    {
+        ds18b20_phy_addr_t slots[ROM_MAP_MAX_SLOTS];
+        uint8_t count; /* Number of used slots including trailing free ones, i.e. highest used slot + 1 */
+    } rom_map_t;
+
+    esp_err_t rom_map_load(rom_map_t *map);
+    esp_err_t rom_map_save(const rom_map_t *map);
+    bool rom_map_slot_is_free(const rom_map_t *map, uint8_t slot);
+    int rom_map_find(const rom_map_t *map, const ds18b20_phy_addr_t addr);
+    int rom_map_allocate(rom_map_t *map, const ds18b20_phy_addr_t addr);
+
+#ifdef __cplusplus
+}
+#endif
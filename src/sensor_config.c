@@ -0,0 +1,88 @@
+#include "sensor_config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "device_config.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "reading_filter.h"
+
+static const char *TAG = "sensor_config.c";
+
+#define SENSOR_CONFIG_NAMESPACE "thermometer"
+
+static void sensor_config_key(uint8_t ep, char *key, size_t size) { snprintf(key, size, "ep%u", ep); }
+
+void sensor_config_load(uint8_t ep, sensor_config_t *config)
+{
+    nvs_handle_t handle;
+    char key[8];
+
+    memset(config, 0, sizeof(sensor_config_t));
+    config->resolution      = device_config_get()->resolution;
+    config->auto_resolution = false;
+    config->median_size     = DS18B20_FILTER_MEDIAN_SIZE;
+    config->ema_shift       = DS18B20_FILTER_EMA_SHIFT;
+    config->spike_threshold = DS18B20_FILTER_SPIKE_THRESHOLD;
+
+    if (nvs_open(SENSOR_CONFIG_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        return;
+    }
+
+    sensor_config_key(ep, key, sizeof(key));
+
+    /* A shorter record written by an older firmware only overrides the leading fields */
+    sensor_config_t stored = *config;
+    size_t size            = sizeof(stored);
+    if (nvs_get_blob(handle, key, &stored, &size) == ESP_OK)
+    {
+        *config = stored;
+    }
+    nvs_close(handle);
+
+    if (config->resolution == 0)
+    {
+        config->resolution = device_config_get()->resolution;
+    }
+    else if (config->resolution < 9 || config->resolution > 12)
+    {
+        ESP_LOGW(TAG, "Invalid stored resolution %d for endpoint %d", config->resolution, ep);
+        config->resolution = device_config_get()->resolution;
+    }
+    if (config->median_size < 1 || config->median_size > READING_FILTER_MEDIAN_MAX || config->ema_shift > READING_FILTER_EMA_SHIFT_MAX)
+    {
+        ESP_LOGW(TAG, "Invalid stored filter settings for endpoint %d", ep);
+        config->median_size = DS18B20_FILTER_MEDIAN_SIZE;
+        config->ema_shift   = DS18B20_FILTER_EMA_SHIFT;
+    }
+}
+
+esp_err_t sensor_config_save(uint8_t ep, const sensor_config_t *config)
+{
+    nvs_handle_t handle;
+    char key[8];
+
+    ESP_RETURN_ON_ERROR(nvs_open(SENSOR_CONFIG_NAMESPACE, NVS_READWRITE, &handle), TAG, "Failed to open NVS namespace");
+
+    /* An endpoint on the device-wide resolution follows its changes */
+    sensor_config_t stored = *config;
+    if (stored.resolution == device_config_get()->resolution)
+    {
+        stored.resolution = 0;
+    }
+
+    sensor_config_key(ep, key, sizeof(key));
+    esp_err_t ret = nvs_set_blob(handle, key, &stored, sizeof(sensor_config_t));
+    if (ret == ESP_OK)
+    {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to write configuration of endpoint %d", ep);
+    return ESP_OK;
+}
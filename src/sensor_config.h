@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SENSOR_CONFIG_CLUSTER_ID 0xFC01              /* Manufacturer-specific per-endpoint sensor configuration cluster */
+#define SENSOR_CONFIG_ATTR_RESOLUTION_ID 0x0000      /* uint8: conversion resolution in bits, 9..12 */
+#define SENSOR_CONFIG_ATTR_AUTO_RESOLUTION_ID 0x0001 /* bool: lower the resolution while the temperature moves fast */
+#define SENSOR_CONFIG_ATTR_MEDIAN_SIZE_ID 0x0002     /* uint8: median filter window, 1..5, 1 disables it */
+#define SENSOR_CONFIG_ATTR_EMA_SHIFT_ID 0x0003       /* uint8: EMA weight 1/2^n, 0..4, 0 disables it */
+#define SENSOR_CONFIG_ATTR_SPIKE_THRESHOLD_ID 0x0004 /* uint16: largest accepted step in 0.01°C, 0 disables the spike rejector */
+#define SENSOR_CONFIG_CMD_MEASURE_ID 0x00            /* To server: resolution u8 (0 keeps the configured one), flags u8; both optional */
+#define SENSOR_CONFIG_MEASURE_ALL 0x01               /* Measure flag: every endpoint instead of the addressed one */
+
+    /* Persisted per endpoint, new fields must be appended so older records still load */
+    typedef struct
+    {
+        uint8_t resolution; /* 0 in a record for the device-wide resolution */
+        bool auto_resolution;
+        uint8_t median_size;
+        uint8_t ema_shift;
+        uint16_t spike_threshold;
+    } sensor_config_t;
+
+    void sensor_config_load(uint8_t ep, sensor_config_t *config);
+    esp_err_t sensor_config_save(uint8_t ep, const sensor_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,124 +1,1465 @@
 #include "thermometer.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "config.h"
-#include "ds18b20.h"
+#include "cycle_scheduler.h"
+#include "device_config.h"
+#include "diagnostics.h"
+#include "driver/gpio.h"
+#include "esp_check.h"
+#include "esp_system.h"
+#include "esp_timer.h"
 #include "esp_zigbee_core.h"
+#include "event_log.h"
 #include "ha/esp_zigbee_ha_standard.h"
+#include "history.h"
 #include "led_driver.h"
+#include "onewire.h"
+#include "ota.h"
+#include "packed_report.h"
+#include "power.h"
+#include "reading_filter.h"
+#include "rom_map.h"
+#include "sensor_config.h"
 #include "zcl/esp_zigbee_zcl_temperature_meas.h"
 
-static const char *TAG = "thermometer.c";
+static const char *TAG = "thermometer.c";
+
+#define DS18B20_MAX_BUSES 8
+#define DS18B20_MAX_READ_ATTEMPTS 31
+#define THERMOMETER_READ_PENDING UINT32_MAX
+
+/* 24 bytes per sensor, 26 with alarm search, kept naturally aligned so the arena needs no padding */
+typedef struct
+{
+    ds18b20_phy_addr_t addr;
+    int16_t value;
+    uint8_t endpoint;
+    uint8_t bus : 3;
+    uint8_t read_attempts : 5;
+    uint8_t resolution : 2;         /* Configured resolution - 9 */
+    uint8_t current_resolution : 2; /* Resolution in use - 9, lower than the configured one while auto resolution dropped it */
+    uint8_t auto_resolution : 1;
+    uint8_t stable_cycles : 3;
+    uint8_t diagnostics_dirty : 1; /* Counters changed since they were last copied to the attribute table */
+    uint8_t reconvert : 1;         /* First read of the cycle failed, converting again for a second read */
+    uint8_t median_size : 3;
+    uint8_t ema_shift : 3;
+    diagnostics_counters_t diagnostics;
+    uint16_t spike_threshold;
+#if DS18B20_ALARM_SEARCH_ENABLE
+    int8_t alarm_degrees; /* Integer degree TH/TL were last written around, INT8_MIN when the scratchpad may differ */
+#endif
+} ds18b20_t;
+
+typedef struct
+{
+    ds18b20_t *ds18b20;        /* Single arena sized at boot from the number of discovered sensors */
+    reading_filter_t *filters; /* Filter state, parallel to ds18b20 */
+    uint8_t count;
+} thermometer_list_t;
+
+typedef struct
+{
+    ds18b20_phy_addr_t addr;
+    uint8_t bus;
+} thermometer_found_t;
+
+/* On-demand measurement request, triggers arriving before it is answered join it */
+typedef struct
+{
+    int64_t triggered_us; /* First trigger, 0 when nothing is requested */
+    uint8_t ep;           /* Endpoint asked for, 0 for every endpoint */
+    uint8_t resolution;   /* Highest resolution asked for, 0 keeps each sensor's own */
+    uint16_t dst_addr;    /* Requester the reports go to, 0xFFFF for the bound devices */
+    uint8_t dst_ep;
+} thermometer_demand_t;
+
+static const gpio_num_t bus_gpios[] = DS18B20_GPIOS;
+
+#define THERMOMETER_BUS_COUNT (sizeof(bus_gpios) / sizeof(bus_gpios[0]))
+
+_Static_assert(THERMOMETER_BUS_COUNT <= DS18B20_MAX_BUSES, "Too many DS18B20 buses");
+_Static_assert(DEVICE_CONFIG_FAILURE_ATTEMPTS_MAX < DS18B20_MAX_READ_ATTEMPTS, "DEVICE_CONFIG_FAILURE_ATTEMPTS_MAX does not fit read_attempts");
+_Static_assert(READING_FILTER_MEDIAN_MAX < 8 && READING_FILTER_EMA_SHIFT_MAX < 8, "Filter settings do not fit median_size/ema_shift");
+_Static_assert(DS18B20_AUTO_RESOLUTION_STABLE_CYCLES < 8, "DS18B20_AUTO_RESOLUTION_STABLE_CYCLES does not fit stable_cycles");
+_Static_assert(DS18B20_FULL_READ_CYCLES > 0, "DS18B20_FULL_READ_CYCLES must be at least 1");
+
+static onewire_bus_t buses[THERMOMETER_BUS_COUNT] = {0};
+
+static thermometer_list_t thermometer_list               = {0};
+static esp_zb_user_cb_handle_t temperature_update_handle = 0;
+static bool temperature_cycle_running                    = false;
+static bool temperature_report_on_join                   = false;
+static int64_t max_stack_hold_us                         = 0;
+static thermometer_stats_t thermometer_stats             = {0};
+static uint32_t cycle_start_slots                        = 0;
+static uint32_t cycle_start_resets                       = 0;
+static uint8_t read_next                                 = 0; /* Next sensor of a full read split over several alarms */
+static thermometer_demand_t demand_pending               = {0}; /* Not started yet */
+static thermometer_demand_t demand_active                = {0}; /* Converting */
+
+/* Strong pullup of each parasite-powered bus: when it was turned on and when its conversion is done, 0 when released */
+static struct
+{
+    int64_t started_us;
+    int64_t done_us;
+} pullups[THERMOMETER_BUS_COUNT] = {0};
+
+#if DS18B20_REDISCOVERY_ENABLE
+static onewire_search_state_t rediscovery_search[THERMOMETER_BUS_COUNT]     = {0};
+static uint8_t rediscovery_bus                                              = 0;
+static uint8_t rediscovery_devices                                          = 0;    /* ROMs found on rediscovery_bus so far */
+static uint8_t *rediscovery_seen                                            = NULL; /* Bitmap over thermometer_list */
+static thermometer_found_t rediscovery_added[DS18B20_REDISCOVERY_MAX_ADDED] = {0};
+static uint8_t rediscovery_added_count                                      = 0;
+#endif
+
+static int ds18b20_compare(const void *a, const void *b) { return memcmp(*(ds18b20_phy_addr_t *)a, *(ds18b20_phy_addr_t *)b, sizeof(ds18b20_phy_addr_t)); }
+
+static int ds18b20_endpoint_compare(const void *a, const void *b) { return ((const ds18b20_t *)a)->endpoint - ((const ds18b20_t *)b)->endpoint; }
+
+static ds18b20_t *thermometer_find_sensor(const ds18b20_phy_addr_t addr)
+{
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        if (memcmp(thermometer_list.ds18b20[i].addr, addr, sizeof(ds18b20_phy_addr_t)) == 0)
+        {
+            return &thermometer_list.ds18b20[i];
+        }
+    }
+    return NULL;
+}
+static ds18b20_t *thermometer_find_endpoint(uint8_t ep)
+{
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        if (thermometer_list.ds18b20[i].endpoint == ep)
+        {
+            return &thermometer_list.ds18b20[i];
+        }
+    }
+    return NULL;
+}
+
+static reading_filter_t *thermometer_filter(const ds18b20_t *ds18b20)
+{
+    return thermometer_list.filters != NULL ? &thermometer_list.filters[ds18b20 - thermometer_list.ds18b20] : NULL;
+}
+
+/* A bus has to wait for the slowest conversion, i.e. the highest resolution in use on it */
+static void thermometer_update_bus_resolution(void)
+{
+    for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT; bus++)
+    {
+        buses[bus].resolution = 9;
+    }
+
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        ds18b20_t *ds18b20 = &thermometer_list.ds18b20[i];
+        if (ds18b20->current_resolution + 9 > buses[ds18b20->bus].resolution)
+        {
+            buses[ds18b20->bus].resolution = ds18b20->current_resolution + 9;
+        }
+    }
+}
+
+static void thermometer_release_pullup(uint8_t bus);
+
+/* Skip ROM addresses the only device of a bus without sending its 64-bit ROM code */
+static const uint8_t *thermometer_address(const ds18b20_t *ds18b20)
+{
+#if DS18B20_SKIP_ROM_SINGLE_DROP
+    if (buses[ds18b20->bus].devices == 1)
+    {
+        return NULL;
+    }
+#endif
+    return ds18b20->addr;
+}
+
+static void thermometer_apply_resolution(ds18b20_t *ds18b20, uint8_t resolution)
+{
+    /* Writing the configuration register also rewrites TH/TL, keep them around the last value for alarm search */
+    int16_t degrees = ds18b20->value >= 0 ? ds18b20->value / 100 : (ds18b20->value - 99) / 100;
+
+    /* Writes only come between conversions, this drops a pullup whose release alarm has not run yet */
+    thermometer_release_pullup(ds18b20->bus);
+
+    ds18b20->current_resolution = resolution - 9;
+    bool written                = ds18b20_write_scratchpad(&buses[ds18b20->bus], thermometer_address(ds18b20), degrees + 1, degrees - 1, resolution);
+#if DS18B20_ALARM_SEARCH_ENABLE
+    ds18b20->alarm_degrees = written ? degrees : INT8_MIN;
+#else
+    (void)written;
+#endif
+    thermometer_update_bus_resolution();
+}
+
+/* A configured resolution the sensor does not have yet, automatic resolution only owes it a lower one and climbs on its own */
+static bool thermometer_resolution_pending(const ds18b20_t *ds18b20)
+{
+    return ds18b20->auto_resolution ? ds18b20->current_resolution > ds18b20->resolution : ds18b20->current_resolution != ds18b20->resolution;
+}
+
+static void thermometer_adapt_resolution(ds18b20_t *ds18b20, int16_t new_value)
+{
+    if (ds18b20->value == (int16_t)0x8000)
+    {
+        return;
+    }
+
+    if (abs(new_value - ds18b20->value) >= DS18B20_AUTO_RESOLUTION_FAST_CHANGE)
+    {
+        ds18b20->stable_cycles = 0;
+        if (ds18b20->current_resolution > 0)
+        {
+            ESP_LOGD(TAG, "Temperature on endpoint %d moves fast, lowering resolution", ds18b20->endpoint);
+            thermometer_apply_resolution(ds18b20, ds18b20->current_resolution + 9 - 1);
+        }
+    }
+    else if (ds18b20->current_resolution < ds18b20->resolution && ++ds18b20->stable_cycles >= DS18B20_AUTO_RESOLUTION_STABLE_CYCLES)
+    {
+        ds18b20->stable_cycles = 0;
+        ESP_LOGD(TAG, "Temperature on endpoint %d is stable, raising resolution", ds18b20->endpoint);
+        thermometer_apply_resolution(ds18b20, ds18b20->current_resolution + 9 + 1);
+    }
+}
+
+static uint32_t thermometer_conversion_time_ms(void)
+{
+    uint8_t resolution = 9;
+
+    for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT; bus++)
+    {
+        if (buses[bus].resolution > resolution)
+        {
+            resolution = buses[bus].resolution;
+        }
+    }
+    return DS18B20_CONVERSION_TIME_MS(resolution);
+}
+
+static void set_temperature_unknown(ds18b20_t *ds18b20)
+{
+    led_driver_set_status(LED_STATUS_READ_ERROR);
+    event_log_record(EVENT_LOG_TEMPERATURE_UNKNOWN, ds18b20->endpoint, 0, 0);
+    thermometer_stats.attribute_writes++;
+    esp_zb_zcl_status_t status = esp_zb_zcl_set_attribute_val(
+        ds18b20->endpoint,
+        ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
+        &(int16_t){0x8000},  // 0x8000 is the Zigbee "invalid/measured value unknown" code, not IEEE NaN (z2m skips NaN values - bug)
+        false);
+
+    if (status != ESP_ZB_ZCL_STATUS_SUCCESS)
+    {
+        ds18b20->diagnostics.set_failures++;
+        ds18b20->diagnostics_dirty = 1;
+    }
+}
+
+static void temperature_release_callback(uint8_t bus) { thermometer_release_pullup(bus); }
+
+static void thermometer_release_pullup(uint8_t bus)
+{
+    if (pullups[bus].started_us == 0)
+    {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    onewire_strong_pullup_release(&buses[bus]);
+    esp_zb_scheduler_alarm_cancel(temperature_release_callback, bus);
+
+    thermometer_stats.pullup_time_us += now_us - pullups[bus].started_us;
+    if (now_us - pullups[bus].done_us > (int64_t)thermometer_stats.pullup_late_us)
+    {
+        thermometer_stats.pullup_late_us = now_us - pullups[bus].done_us;
+    }
+    pullups[bus].started_us = 0;
+}
+
+static void thermometer_release_pullups(void)
+{
+    for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT; bus++)
+    {
+        thermometer_release_pullup(bus);
+    }
+}
+
+/* A parasite-powered bus gets its own release alarm after the conversion time of its resolution,
+   instead of staying driven until the slowest bus is read */
+static void thermometer_convert(uint8_t bus, const uint8_t *addr, uint8_t resolution)
+{
+    if (!ds18b20_convert(&buses[bus], addr) || !buses[bus].parasite)
+    {
+        return;
+    }
+
+    uint32_t conversion_time_ms = DS18B20_CONVERSION_TIME_MS(resolution);
+    pullups[bus].started_us     = esp_timer_get_time();
+    pullups[bus].done_us        = pullups[bus].started_us + conversion_time_ms * 1000;
+    esp_zb_scheduler_alarm(temperature_release_callback, bus, conversion_time_ms);
+}
+
+/* Time slots on every bus since boot, the reset sequences are counted apart as each one is about 16 slots long */
+static uint32_t thermometer_bus_slots(void)
+{
+    uint32_t slots = 0;
+    for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT; bus++)
+    {
+        slots += buses[bus].stats.bytes * 8 + buses[bus].stats.bits;
+    }
+    return slots;
+}
+
+static uint32_t thermometer_bus_resets(void)
+{
+    uint32_t resets = 0;
+    for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT; bus++)
+    {
+        resets += buses[bus].stats.resets;
+    }
+    return resets;
+}
+
+void thermometer_request_conversion(void)
+{
+    led_driver_set_status(LED_STATUS_READING);
+
+    thermometer_stats.bus_time_us      = 0;
+    thermometer_stats.attribute_writes = 0;
+    thermometer_stats.read_failures    = 0;
+    thermometer_stats.pullup_time_us   = 0;
+    thermometer_stats.stack_hold_us    = 0;
+    cycle_start_slots                  = thermometer_bus_slots();
+    cycle_start_resets                 = thermometer_bus_resets();
+
+    /* Broadcast Convert T on every bus and return immediately, the conversions run concurrently
+       and the scratchpads are read by a later alarm */
+    int64_t bus_started_us = esp_timer_get_time();
+    for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT; bus++)
+    {
+        thermometer_convert(bus, NULL, buses[bus].resolution);
+    }
+    thermometer_stats.bus_time_us += esp_timer_get_time() - bus_started_us;
+}
+
+#if DS18B20_ALARM_SEARCH_ENABLE
+static void thermometer_set_alarm_window(ds18b20_t *ds18b20, int16_t value)
+{
+    /* The DS18B20 compares only the integer part: TL = n - 1 and TH = n + 1 raise the alarm
+       as soon as the integer degree of the reading changes */
+    int16_t degrees    = value >= 0 ? value / 100 : (value - 99) / 100;
+    onewire_bus_t *dev = &buses[ds18b20->bus];
+
+    /* Most reads of a full-read cycle find the sensor within its window, which is then already in place */
+    if (degrees == ds18b20->alarm_degrees)
+    {
+        return;
+    }
+
+    int64_t bus_started_us = esp_timer_get_time();
+    bool written           = ds18b20_write_scratchpad(dev, thermometer_address(ds18b20), degrees + 1, degrees - 1, ds18b20->current_resolution + 9);
+    thermometer_stats.bus_time_us += esp_timer_get_time() - bus_started_us;
+    ds18b20->alarm_degrees = written ? degrees : INT8_MIN;
+}
+
+#endif
+
+/* Bytes worth reading: the temperature register alone, with a CRC-verified full read every DS18B20_FULL_READ_CYCLES
+   cycles, staggered over the sensors, and whenever the last reading is not trusted. Skip ROM on a bus whose device
+   count no search has confirmed yet could have a second device answer, only the CRC tells that apart. */
+static uint8_t thermometer_read_length(const ds18b20_t *ds18b20)
+{
+    uint32_t index = ds18b20 - thermometer_list.ds18b20;
+    if (ds18b20->read_attempts > 0 || ds18b20->value == (int16_t)0x8000 || (thermometer_stats.cycles + index) % DS18B20_FULL_READ_CYCLES == 0 ||
+        (thermometer_address(ds18b20) == NULL && !buses[ds18b20->bus].devices_confirmed))
+    {
+        return DS18B20_SCRATCHPAD_SIZE;
+    }
+    return DS18B20_SCRATCHPAD_TEMPERATURE_SIZE;
+}
+
+/* Values a truncated read cannot tell apart from a shorted or floating line or from the power-on 85 °C */
+static bool thermometer_needs_full_read(const uint8_t *scratchpad)
+{
+    uint16_t raw = scratchpad[1] << 8 | scratchpad[0];
+    return raw == 0x0000 || raw == 0xFFFF || raw == DS18B20_POWER_ON_RESET_RAW;
+}
+
+/* A failed transfer does not spoil the conversion, the result stays in the scratchpad until the next Convert T.
+   The first attempt uses the cheapest sequence the planner allows, retries fall back to Match ROM and a full read. */
+static esp_err_t thermometer_read_scratchpad(ds18b20_t *ds18b20, uint8_t *scratchpad)
+{
+    esp_err_t err       = ESP_FAIL;
+    onewire_bus_t *dev  = &buses[ds18b20->bus];
+    const uint8_t *addr = thermometer_address(ds18b20);
+    uint8_t len         = thermometer_read_length(ds18b20);
+
+    int64_t bus_started_us = esp_timer_get_time();
+    for (uint8_t attempt = 0; attempt <= DS18B20_REREAD_ATTEMPTS; attempt++)
+    {
+        if (attempt > 0)
+        {
+            ds18b20->diagnostics.retries++;
+            addr = ds18b20->addr;
+            len  = DS18B20_SCRATCHPAD_SIZE;
+        }
+
+        err = ds18b20_read_scratchpad(dev, addr, scratchpad, len);
+        if (err == ESP_OK && len < DS18B20_SCRATCHPAD_SIZE && thermometer_needs_full_read(scratchpad))
+        {
+            len = DS18B20_SCRATCHPAD_SIZE;
+            err = ds18b20_read_scratchpad(dev, addr, scratchpad, len);
+        }
+        if (err == ESP_OK)
+        {
+            break;
+        }
+
+        if (err == ESP_ERR_INVALID_CRC)
+        {
+            ds18b20->diagnostics.crc_failures++;
+        }
+        else
+        {
+            ds18b20->diagnostics.disconnects++;
+        }
+        ds18b20->diagnostics_dirty = 1;
+    }
+    thermometer_stats.bus_time_us += esp_timer_get_time() - bus_started_us;
+
+    if (err != ESP_OK || len < DS18B20_SCRATCHPAD_SIZE)
+    {
+        return err;
+    }
+
+    if (scratchpad[0] == (DS18B20_POWER_ON_RESET_RAW & 0xFF) && scratchpad[1] == DS18B20_POWER_ON_RESET_RAW >> 8 &&
+        scratchpad[DS18B20_SCRATCHPAD_RESERVED] == DS18B20_POWER_ON_RESET_RESERVED)
+    {
+        /* The sensor lost power after the Convert T, 85 °C is its reset value and not a reading */
+        ds18b20->diagnostics.disconnects++;
+        ds18b20->diagnostics_dirty = 1;
+        err                        = ESP_ERR_INVALID_STATE;
+    }
+
+#if DS18B20_ALARM_SEARCH_ENABLE
+    if ((int8_t)scratchpad[DS18B20_SCRATCHPAD_TH] != ds18b20->alarm_degrees + 1 || (int8_t)scratchpad[DS18B20_SCRATCHPAD_TL] != ds18b20->alarm_degrees - 1)
+    {
+        /* Back to the EEPROM TH/TL, the window is written again after this read */
+        ds18b20->alarm_degrees = INT8_MIN;
+    }
+#endif
+
+    if (scratchpad[DS18B20_SCRATCHPAD_CONFIG] != DS18B20_CONFIG_RESOLUTION(ds18b20->current_resolution + 9))
+    {
+        /* Back to the EEPROM configuration after a power loss, TH/TL need restoring as well */
+        ESP_LOGW(TAG, "DS18B20 on endpoint %d lost its configuration, restoring it", ds18b20->endpoint);
+        bus_started_us = esp_timer_get_time();
+        thermometer_apply_resolution(ds18b20, ds18b20->current_resolution + 9);
+        thermometer_stats.bus_time_us += esp_timer_get_time() - bus_started_us;
+    }
+
+    return err;
+}
+
+/* Returns false when the reading failed; unless it is the last try the sensor is left for a re-convert */
+static bool thermometer_read_sensor(ds18b20_t *ds18b20, bool last_try)
+{
+    uint8_t ep = ds18b20->endpoint;
+    uint8_t scratchpad[DS18B20_SCRATCHPAD_SIZE];
+
+    esp_err_t err = thermometer_read_scratchpad(ds18b20, scratchpad);
+    if (err != ESP_OK)
+    {
+        if (!last_try)
+        {
+            ds18b20->reconvert = 1;
+            return false;
+        }
+
+        ESP_LOGW(TAG, "Failed to read temperature for endpoint %d: %s", ep, esp_err_to_name(err));
+        thermometer_stats.read_failures++;
+
+        uint8_t failure_attempts = device_config_get()->failure_attempts;
+        if (ds18b20->read_attempts <= failure_attempts)
+        {
+            ds18b20->read_attempts++;
+        }
+        if (ds18b20->read_attempts > failure_attempts)
+        {
+            set_temperature_unknown(ds18b20);
+            ds18b20->value = (int16_t)0x8000;
+            if (thermometer_filter(ds18b20) != NULL)
+            {
+                reading_filter_reset(thermometer_filter(ds18b20));
+            }
+        }
+        return false;
+    }
+
+    ds18b20->read_attempts = 0;
+
+    /* Temperature register in 1/16 °C, the bits below the resolution in use are undefined */
+    int16_t raw       = (int16_t)((scratchpad[1] << 8 | scratchpad[0]) & ~((1 << (3 - ds18b20->current_resolution)) - 1));
+    int16_t new_value = (int16_t)((int32_t)raw * 25 / 4); /* 0.01 °C, exact for every resolution */
+
+    /* Automatic resolution reacts to the raw reading, the filter would hide fast changes */
+    if (ds18b20->auto_resolution)
+    {
+        thermometer_adapt_resolution(ds18b20, new_value);
+    }
+
+    reading_filter_t *filter              = thermometer_filter(ds18b20);
+    reading_filter_config_t filter_config = {
+        .median_size     = ds18b20->median_size,
+        .ema_shift       = ds18b20->ema_shift,
+        .spike_threshold = ds18b20->spike_threshold,
+    };
+    if (filter != NULL && !reading_filter_apply(filter, &filter_config, &new_value))
+    {
+        ESP_LOGD(TAG, "Rejected spike on endpoint %d", ep);
+        return true;
+    }
+
+#if DS18B20_ALARM_SEARCH_ENABLE
+    thermometer_set_alarm_window(ds18b20, new_value);
+#endif
+
+    /* Deciding whether the change is worth a report is left to the stack's reporting configuration */
+    if (ds18b20->value == new_value)
+    {
+        return true;
+    }
+
+    ds18b20->value = new_value;
+
+    thermometer_stats.attribute_writes++;
+    esp_zb_zcl_status_t status = esp_zb_zcl_set_attribute_val(
+        ep, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, &ds18b20->value, false);
+
+    if (status != ESP_ZB_ZCL_STATUS_SUCCESS)
+    {
+        ESP_LOGW(TAG, "Failed to update temperature for endpoint %d, status: %d", ep, status);
+        ds18b20->diagnostics.set_failures++;
+        ds18b20->diagnostics_dirty = 1;
+    }
+    else
+    {
+        event_log_record(EVENT_LOG_TEMPERATURE_UPDATED, ep, 0, ds18b20->value);
+    }
+    return true;
+}
+
+/* Returns the time to wait for sensors converted again, or THERMOMETER_READ_PENDING when sensors are left for the next alarm */
+static uint32_t thermometer_read_values(int64_t started_us)
+{
+    if (read_next == 0)
+    {
+        led_driver_set_status(LED_STATUS_OFF);
+        /* Release alarms due at the same time may not have run yet */
+        thermometer_release_pullups();
+    }
+
+#if DS18B20_ALARM_SEARCH_ENABLE
+    /* Only sensors that left their TH/TL window answer the alarm search; every sensor is
+       still read periodically to notice failures and refresh windows lost on power loss */
+    if (thermometer_stats.cycles % DS18B20_ALARM_FULL_READ_CYCLES != 0)
+    {
+        ds18b20_phy_addr_t addr;
+
+        for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT; bus++)
+        {
+            int64_t bus_started_us = esp_timer_get_time();
+            int r                  = onewire_search(&buses[bus], ONEWIRE_CMD_ALARM_SEARCH, addr);
+            thermometer_stats.bus_time_us += esp_timer_get_time() - bus_started_us;
+
+            while (r > 0)
+            {
+                ds18b20_t *ds18b20 = thermometer_find_sensor(addr);
+                if (ds18b20 != NULL)
+                {
+                    thermometer_read_sensor(ds18b20, false);
+                }
+
+                bus_started_us = esp_timer_get_time();
+                r              = onewire_search(&buses[bus], ONEWIRE_CMD_ALARM_SEARCH, addr);
+                thermometer_stats.bus_time_us += esp_timer_get_time() - bus_started_us;
+            }
+        }
+    }
+    else
+#endif
+    {
+        /* A resolution changed by the coordinator is written after the sensor's read, in the next slice so that
+           no slice holds the stack for more than one transaction past its end */
+        bool written = false;
+        if (read_next > 0 && thermometer_resolution_pending(&thermometer_list.ds18b20[read_next - 1]))
+        {
+            ds18b20_t *ds18b20     = &thermometer_list.ds18b20[read_next - 1];
+            int64_t bus_started_us = esp_timer_get_time();
+            thermometer_apply_resolution(ds18b20, ds18b20->resolution + 9);
+            thermometer_stats.bus_time_us += esp_timer_get_time() - bus_started_us;
+            written = true;
+        }
+
+        /* At least one transaction per alarm, the stack gets the task back once the slice is used up */
+        while (read_next < thermometer_list.count && !(written && esp_timer_get_time() - started_us >= DS18B20_READ_SLICE_US))
+        {
+            ds18b20_t *ds18b20 = &thermometer_list.ds18b20[read_next++];
+            thermometer_read_sensor(ds18b20, false);
+            if (thermometer_resolution_pending(ds18b20) ||
+                (read_next < thermometer_list.count && esp_timer_get_time() - started_us >= DS18B20_READ_SLICE_US))
+            {
+                return THERMOMETER_READ_PENDING;
+            }
+        }
+        if (read_next < thermometer_list.count)
+        {
+            return THERMOMETER_READ_PENDING;
+        }
+        read_next = 0;
+    }
+
+    /* Convert only the sensors that failed, instead of waiting a whole interval for the next cycle */
+    uint32_t reconvert_time_ms = 0;
+    uint8_t parasite_buses     = 0;
+    int64_t bus_started_us     = esp_timer_get_time();
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        ds18b20_t *ds18b20 = &thermometer_list.ds18b20[i];
+        if (!ds18b20->reconvert)
+        {
+            continue;
+        }
+
+        ds18b20->diagnostics.retries++;
+        ds18b20->diagnostics_dirty = 1;
+
+        uint8_t resolution = ds18b20->current_resolution + 9;
+        if (buses[ds18b20->bus].parasite)
+        {
+            /* Addressing the next sensor would cut the power of a running parasite conversion, the whole bus converts once */
+            parasite_buses |= 1 << ds18b20->bus;
+            resolution = buses[ds18b20->bus].resolution;
+        }
+        else
+        {
+            thermometer_convert(ds18b20->bus, ds18b20->addr, resolution);
+        }
+
+        uint32_t conversion_time_ms = DS18B20_CONVERSION_TIME_MS(resolution);
+        if (conversion_time_ms > reconvert_time_ms)
+        {
+            reconvert_time_ms = conversion_time_ms;
+        }
+    }
+    for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT; bus++)
+    {
+        if (parasite_buses & (1 << bus))
+        {
+            thermometer_convert(bus, NULL, buses[bus].resolution);
+        }
+    }
+    thermometer_stats.bus_time_us += esp_timer_get_time() - bus_started_us;
+
+    return reconvert_time_ms;
+}
+
+static void thermometer_reread_values(void)
+{
+    thermometer_release_pullups();
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        ds18b20_t *ds18b20 = &thermometer_list.ds18b20[i];
+        if (ds18b20->reconvert)
+        {
+            ds18b20->reconvert = 0;
+            thermometer_read_sensor(ds18b20, true);
+        }
+    }
+}
+
+/* Bound devices get it when dst_addr is 0xFFFF */
+static void thermometer_report(uint8_t ep, uint16_t dst_addr, uint8_t dst_ep)
+{
+    esp_zb_zcl_report_attr_cmd_t report_attr_cmd = {
+        .zcl_basic_cmd.src_endpoint = ep,
+        .address_mode               = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT,
+        .clusterID                  = ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+        .attributeID                = ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
+        .direction                  = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
+    };
+    if (dst_addr != 0xFFFF)
+    {
+        report_attr_cmd.address_mode                        = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+        report_attr_cmd.zcl_basic_cmd.dst_addr_u.addr_short = dst_addr;
+        report_attr_cmd.zcl_basic_cmd.dst_endpoint          = dst_ep;
+    }
+    esp_zb_zcl_report_attr_cmd_req(&report_attr_cmd);
+}
+
+static bool thermometer_demanded(const thermometer_demand_t *demand, const ds18b20_t *ds18b20)
+{
+    return demand->ep == 0 || demand->ep == ds18b20->endpoint;
+}
+
+/* Resolution a demanded sensor converts at: the requested one when it is lower than the sensor's */
+static uint8_t thermometer_demand_resolution(const thermometer_demand_t *demand, const ds18b20_t *ds18b20)
+{
+    uint8_t resolution = ds18b20->current_resolution + 9;
+    return demand->resolution != 0 && demand->resolution < resolution ? demand->resolution : resolution;
+}
+
+static uint32_t thermometer_demand_conversion_time_ms(const thermometer_demand_t *demand)
+{
+    uint8_t resolution = 9;
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        ds18b20_t *ds18b20 = &thermometer_list.ds18b20[i];
+        if (thermometer_demanded(demand, ds18b20) && thermometer_demand_resolution(demand, ds18b20) > resolution)
+        {
+            resolution = thermometer_demand_resolution(demand, ds18b20);
+        }
+    }
+    return DS18B20_CONVERSION_TIME_MS(resolution);
+}
+
+static void thermometer_answer_demand(thermometer_demand_t *demand)
+{
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        if (thermometer_demanded(demand, &thermometer_list.ds18b20[i]))
+        {
+            thermometer_report(thermometer_list.ds18b20[i].endpoint, demand->dst_addr, demand->dst_ep);
+        }
+    }
+    cycle_scheduler_demand_answered(demand->triggered_us);
+    demand->triggered_us = 0;
+}
+
+static void thermometer_finish_cycle(void)
+{
+#if DS18B20_PACKED_REPORT_ENABLE
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        packed_report_add(thermometer_list.ds18b20[i].endpoint, thermometer_list.ds18b20[i].value);
+    }
+    packed_report_send(thermometer_list.ds18b20[0].endpoint);
+#endif
+
+#if DS18B20_HISTORY_ENABLE
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        history_add(thermometer_list.ds18b20[i].endpoint, thermometer_list.ds18b20[i].value);
+    }
+    history_commit();
+#endif
+
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        ds18b20_t *ds18b20 = &thermometer_list.ds18b20[i];
+        if (ds18b20->diagnostics_dirty)
+        {
+            ds18b20->diagnostics_dirty = 0;
+            diagnostics_publish(ds18b20->endpoint, &ds18b20->diagnostics);
+        }
+    }
+    thermometer_stats.bus_slots  = thermometer_bus_slots() - cycle_start_slots;
+    thermometer_stats.bus_resets = thermometer_bus_resets() - cycle_start_resets;
+    diagnostics_publish_bus_time(thermometer_list.ds18b20[0].endpoint, thermometer_stats.bus_time_us, thermometer_stats.bus_slots);
+
+    if (temperature_report_on_join)
+    {
+        /* The readings taken before the join were never reported and reporting only fires on the next change */
+        temperature_report_on_join = false;
+        for (uint8_t i = 0; i < thermometer_list.count; i++)
+        {
+            thermometer_report(thermometer_list.ds18b20[i].endpoint, 0xFFFF, 0);
+        }
+        cycle_scheduler_reported();
+    }
+
+    if (demand_pending.triggered_us != 0)
+    {
+        /* Triggered while this cycle was converting, its readings are as fresh as a separate conversion */
+        thermometer_answer_demand(&demand_pending);
+    }
+
+    power_cycle_end();
+
+    uint64_t bus_cpu_us = 0;
+    uint32_t bus_bytes  = 0;
+    for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT; bus++)
+    {
+        bus_cpu_us += buses[bus].stats.cpu_us;
+        bus_bytes += buses[bus].stats.bytes + buses[bus].stats.bits / 8;
+    }
+    thermometer_stats.bus_cpu_ns = bus_bytes > 0 ? bus_cpu_us * 1000 / bus_bytes : 0;
+
+    thermometer_stats.cycles++;
+    if (thermometer_stats.read_failures == 0)
+    {
+        led_driver_clear_status(LED_STATUS_READ_ERROR);
+    }
+    ESP_LOGD(
+        TAG,
+        "Cycle %lu: bus time %lu us (%lu slots, %lu resets, CPU %lu ns/byte), %u attribute writes, %u read failures, strong pullup %lu us "
+        "(%lu us late at most)",
+        thermometer_stats.cycles,
+        thermometer_stats.bus_time_us,
+        thermometer_stats.bus_slots,
+        thermometer_stats.bus_resets,
+        thermometer_stats.bus_cpu_ns,
+        thermometer_stats.attribute_writes,
+        thermometer_stats.read_failures,
+        thermometer_stats.pullup_time_us,
+        thermometer_stats.pullup_late_us);
+}
+
+const thermometer_stats_t *thermometer_get_stats(void) { return &thermometer_stats; }
+
+static void temperature_convert_callback(void *param);
+
+static void thermometer_configure_reporting(uint8_t ep)
+{
+    /* Defaults only: Configure Reporting commands from the coordinator override them per endpoint */
+    esp_zb_zcl_reporting_info_t reporting_info = {
+        .direction                    = ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV,
+        .ep                           = ep,
+        .cluster_id                   = ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+        .cluster_role                 = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        .attr_id                      = ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
+        .dst.profile_id               = ESP_ZB_AF_HA_PROFILE_ID,
+        .u.send_info.min_interval     = DS18B20_REPORT_MIN_INTERVAL,
+        .u.send_info.max_interval     = DS18B20_REPORT_MAX_INTERVAL,
+        .u.send_info.def_min_interval = DS18B20_REPORT_MIN_INTERVAL,
+        .u.send_info.def_max_interval = DS18B20_REPORT_MAX_INTERVAL,
+        .u.send_info.delta.s16        = device_config_get()->reportable_change,
+        .manuf_code                   = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC,
+    };
+
+    if (esp_zb_zcl_update_reporting_info(&reporting_info) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to configure reporting for endpoint %d", ep);
+    }
+}
+
+static esp_err_t thermometer_set_filter(ds18b20_t *ds18b20, const sensor_config_t *config)
+{
+    ds18b20->median_size     = config->median_size;
+    ds18b20->ema_shift       = config->ema_shift;
+    ds18b20->spike_threshold = config->spike_threshold;
+    if (thermometer_filter(ds18b20) != NULL)
+    {
+        reading_filter_reset(thermometer_filter(ds18b20));
+    }
+
+    ESP_LOGI(
+        TAG,
+        "Endpoint %d filter set to median %d, EMA 1/%d, spike threshold %d",
+        ds18b20->endpoint,
+        config->median_size,
+        1 << config->ema_shift,
+        config->spike_threshold);
+    return sensor_config_save(ds18b20->endpoint, config);
+}
+
+static esp_err_t thermometer_reset_diagnostics(ds18b20_t *ds18b20, uint16_t attr_id)
+{
+    if (diagnostics_reset(&ds18b20->diagnostics, attr_id))
+    {
+        ESP_LOGI(TAG, "Diagnostics counter 0x%04x reset on endpoint %d", attr_id, ds18b20->endpoint);
+    }
+    /* Publishing also puts back whatever value the coordinator wrote */
+    diagnostics_publish(ds18b20->endpoint, &ds18b20->diagnostics);
+    return ESP_OK;
+}
+
+static esp_err_t thermometer_set_device_config(uint8_t ep, uint16_t attr_id, const void *value)
+{
+    ESP_RETURN_ON_FALSE(value, ESP_ERR_INVALID_ARG, TAG, "Empty attribute value");
+
+    uint8_t previous_resolution = device_config_get()->resolution;
+    esp_err_t err               = device_config_set(ep, attr_id, value);
+    if (err != ESP_OK)
+    {
+        return err == ESP_ERR_NOT_FOUND ? ESP_OK : err;
+    }
+
+    const device_config_t *device_config = device_config_get();
+    switch (attr_id)
+    {
+        case DEVICE_CONFIG_ATTR_UPDATE_INTERVAL_ID:
+        {
+            uint32_t delay_ms = cycle_scheduler_set_period(device_config->update_interval);
+            /* A running cycle picks the new period up when it finishes, an idle one is moved right away */
+            if (!temperature_cycle_running)
+            {
+                esp_zb_scheduler_user_alarm_cancel(temperature_update_handle);
+                temperature_update_handle = esp_zb_scheduler_user_alarm(temperature_convert_callback, NULL, delay_ms);
+            }
+            power_set_poll_interval(device_config->update_interval);
+            ESP_LOGI(TAG, "Update interval set to %lu ms", device_config->update_interval);
+            break;
+        }
+        case DEVICE_CONFIG_ATTR_REPORTABLE_CHANGE_ID:
+            for (uint8_t i = 0; i < thermometer_list.count; i++)
+            {
+                /* Keep the intervals a Configure Reporting command may have set, only the change is replaced */
+                esp_zb_zcl_attr_location_info_t location = {
+                    .endpoint_id  = thermometer_list.ds18b20[i].endpoint,
+                    .cluster_id   = ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+                    .cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                    .manuf_code   = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC,
+                    .attr_id      = ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
+                };
+                esp_zb_zcl_reporting_info_t *current = esp_zb_zcl_find_reporting_info(location);
+                if (current == NULL)
+                {
+                    thermometer_configure_reporting(location.endpoint_id);
+                    continue;
+                }
+
+                esp_zb_zcl_reporting_info_t reporting_info = *current;
+                reporting_info.u.send_info.delta.s16       = device_config->reportable_change;
+                if (esp_zb_zcl_update_reporting_info(&reporting_info) != ESP_OK)
+                {
+                    ESP_LOGW(TAG, "Failed to update reportable change for endpoint %d", location.endpoint_id);
+                }
+            }
+            ESP_LOGI(TAG, "Reportable change set to %u", device_config->reportable_change);
+            break;
+        case DEVICE_CONFIG_ATTR_FAILURE_ATTEMPTS_ID:
+            /* Read on every failure, nothing to apply */
+            ESP_LOGI(TAG, "Failure attempts set to %u", device_config->failure_attempts);
+            break;
+        case DEVICE_CONFIG_ATTR_RESOLUTION_ID:
+        {
+            /* Stored once above, the endpoints that followed the old value follow the new one without records of their
+               own. Their sensors are written by the cycle, one after each read */
+            uint8_t resolution = device_config->resolution;
+            uint8_t followers  = 0;
+            for (uint8_t i = 0; i < thermometer_list.count; i++)
+            {
+                ds18b20_t *ds18b20 = &thermometer_list.ds18b20[i];
+                if (ds18b20->resolution + 9 != previous_resolution)
+                {
+                    continue;
+                }
+
+                ds18b20->resolution    = resolution - 9;
+                ds18b20->stable_cycles = 0;
+                esp_zb_zcl_set_attribute_val(
+                    ds18b20->endpoint, SENSOR_CONFIG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, SENSOR_CONFIG_ATTR_RESOLUTION_ID, &resolution, false);
+                followers++;
+            }
+            ESP_LOGI(TAG, "Resolution set to %u bits on %u endpoints", resolution, followers);
+            break;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t thermometer_set_attribute(const esp_zb_zcl_set_attr_value_message_t *message)
+{
+    if (message->info.cluster == DEVICE_CONFIG_CLUSTER_ID)
+    {
+        return thermometer_set_device_config(message->info.dst_endpoint, message->attribute.id, message->attribute.data.value);
+    }
+    if (message->info.cluster != SENSOR_CONFIG_CLUSTER_ID && message->info.cluster != ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS)
+    {
+        return ESP_OK;
+    }
+
+    uint8_t ep         = message->info.dst_endpoint;
+    ds18b20_t *ds18b20 = thermometer_find_endpoint(ep);
+    ESP_RETURN_ON_FALSE(ds18b20, ESP_ERR_NOT_FOUND, TAG, "No DS18B20 device on endpoint %d", ep);
+
+    if (message->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS)
+    {
+        return thermometer_reset_diagnostics(ds18b20, message->attribute.id);
+    }
+
+    ESP_RETURN_ON_FALSE(message->attribute.data.value, ESP_ERR_INVALID_ARG, TAG, "Empty attribute value");
+
+    sensor_config_t config = {
+        .resolution      = ds18b20->resolution + 9,
+        .auto_resolution = ds18b20->auto_resolution,
+        .median_size     = ds18b20->median_size,
+        .ema_shift       = ds18b20->ema_shift,
+        .spike_threshold = ds18b20->spike_threshold,
+    };
+
+    switch (message->attribute.id)
+    {
+        case SENSOR_CONFIG_ATTR_RESOLUTION_ID:
+        {
+            uint8_t resolution = *(uint8_t *)message->attribute.data.value;
+            if (resolution < 9 || resolution > 12)
+            {
+                /* Put the valid value back, the stack has already stored the rejected one */
+                esp_zb_zcl_set_attribute_val(ep, SENSOR_CONFIG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, SENSOR_CONFIG_ATTR_RESOLUTION_ID, &config.resolution, false);
+                ESP_LOGW(TAG, "Rejected resolution %d for endpoint %d", resolution, ep);
+                return ESP_ERR_INVALID_ARG;
+            }
+            config.resolution = resolution;
+            break;
+        }
+        case SENSOR_CONFIG_ATTR_AUTO_RESOLUTION_ID:
+            config.auto_resolution = *(bool *)message->attribute.data.value;
+            break;
+        case SENSOR_CONFIG_ATTR_MEDIAN_SIZE_ID:
+        {
+            uint8_t median_size = *(uint8_t *)message->attribute.data.value;
+            if (median_size < 1 || median_size > READING_FILTER_MEDIAN_MAX)
+            {
+                esp_zb_zcl_set_attribute_val(ep, SENSOR_CONFIG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, SENSOR_CONFIG_ATTR_MEDIAN_SIZE_ID, &config.median_size, false);
+                ESP_LOGW(TAG, "Rejected median size %d for endpoint %d", median_size, ep);
+                return ESP_ERR_INVALID_ARG;
+            }
+            config.median_size = median_size;
+            return thermometer_set_filter(ds18b20, &config);
+        }
+        case SENSOR_CONFIG_ATTR_EMA_SHIFT_ID:
+        {
+            uint8_t ema_shift = *(uint8_t *)message->attribute.data.value;
+            if (ema_shift > READING_FILTER_EMA_SHIFT_MAX)
+            {
+                esp_zb_zcl_set_attribute_val(ep, SENSOR_CONFIG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, SENSOR_CONFIG_ATTR_EMA_SHIFT_ID, &config.ema_shift, false);
+                ESP_LOGW(TAG, "Rejected EMA shift %d for endpoint %d", ema_shift, ep);
+                return ESP_ERR_INVALID_ARG;
+            }
+            config.ema_shift = ema_shift;
+            return thermometer_set_filter(ds18b20, &config);
+        }
+        case SENSOR_CONFIG_ATTR_SPIKE_THRESHOLD_ID:
+            config.spike_threshold = *(uint16_t *)message->attribute.data.value;
+            return thermometer_set_filter(ds18b20, &config);
+        default:
+            return ESP_OK;
+    }
+
+    /* The cycle writes the sensor after its next read */
+    ds18b20->resolution      = config.resolution - 9;
+    ds18b20->auto_resolution = config.auto_resolution;
+    ds18b20->stable_cycles   = 0;
+
+    ESP_LOGI(TAG, "Endpoint %d resolution set to %d bits%s", ep, config.resolution, config.auto_resolution ? " (automatic)" : "");
+    return sensor_config_save(ep, &config);
+}
+
+static void track_stack_hold_time(int64_t started_us, const char *phase)
+{
+    int64_t hold_us = esp_timer_get_time() - started_us;
+    if (hold_us > thermometer_stats.stack_hold_us)
+    {
+        thermometer_stats.stack_hold_us = hold_us;
+    }
+    if (hold_us > max_stack_hold_us)
+    {
+        max_stack_hold_us = hold_us;
+        ESP_LOGI(TAG, "New longest Zigbee scheduler hold: %lld us (%s)", max_stack_hold_us, phase);
+    }
+}
+
+#if DS18B20_REDISCOVERY_ENABLE
+static void thermometer_rediscovered(const ds18b20_phy_addr_t addr, uint8_t bus)
+{
+    ds18b20_t *ds18b20 = thermometer_find_sensor(addr);
+    if (ds18b20 != NULL)
+    {
+        uint8_t i = ds18b20 - thermometer_list.ds18b20;
+        rediscovery_seen[i / 8] |= 1 << (i % 8);
+        return;
+    }
+
+    for (uint8_t i = 0; i < rediscovery_added_count; i++)
+    {
+        if (memcmp(rediscovery_added[i].addr, addr, sizeof(ds18b20_phy_addr_t)) == 0)
+        {
+            return;
+        }
+    }
+
+    /* A new ROM has to read back as a DS18B20 before it is worth a restart */
+    uint8_t scratchpad[DS18B20_SCRATCHPAD_SIZE];
+    if (addr[0] != DS18B20_FAMILY_CODE || rediscovery_added_count == DS18B20_REDISCOVERY_MAX_ADDED ||
+        ds18b20_read_scratchpad(&buses[bus], addr, scratchpad, DS18B20_SCRATCHPAD_SIZE) != ESP_OK)
+    {
+        return;
+    }
+
+    ESP_LOGI(TAG, "New DS18B20 device %02x-%02x%02x%02x%02x%02x%02x on bus %d", addr[0], addr[6], addr[5], addr[4], addr[3], addr[2], addr[1], bus);
+    memcpy(rediscovery_added[rediscovery_added_count].addr, addr, sizeof(ds18b20_phy_addr_t));
+    rediscovery_added[rediscovery_added_count++].bus = bus;
+}
+
+/* Endpoints can only be registered before the stack starts, so new sensors are added to the ROM map and picked up by a restart */
+static void thermometer_rediscovery_pass_done(void)
+{
+    bool changed   = false;
+    rom_map_t *map = malloc(sizeof(rom_map_t));
+    if (map == NULL)
+    {
+        ESP_LOGW(TAG, "Out of memory for the ROM map, rediscovery results dropped");
+        return;
+    }
+    if (rom_map_load(map) != ESP_OK)
+    {
+        map->count = 0;
+    }
+
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        ds18b20_t *ds18b20 = &thermometer_list.ds18b20[i];
+        uint8_t slot       = ds18b20->endpoint - DS18B20_FIRST_ENDPOINT;
+        bool seen          = rediscovery_seen[i / 8] & (1 << (i % 8));
+        int mapped         = rom_map_find(map, ds18b20->addr);
+
+        if (!seen && mapped >= 0 && ds18b20->read_attempts > device_config_get()->failure_attempts)
+        {
+            /* The endpoint keeps reporting unknown until the next restart drops it */
+            ESP_LOGI(TAG, "DS18B20 device on endpoint %d was removed", ds18b20->endpoint);
+            memset(map->slots[mapped], 0, sizeof(ds18b20_phy_addr_t));
+            changed = true;
+        }
+        else if (seen && mapped < 0 && (slot >= map->count || rom_map_slot_is_free(map, slot)))
+        {
+            ESP_LOGI(TAG, "DS18B20 device on endpoint %d is back", ds18b20->endpoint);
+            memcpy(map->slots[slot], ds18b20->addr, sizeof(ds18b20_phy_addr_t));
+            if (slot >= map->count)
+            {
+                map->count = slot + 1;
+            }
+            changed = true;
+        }
+    }
+
+    bool added = false;
+    for (uint8_t i = 0; i < rediscovery_added_count; i++)
+    {
+        if (rom_map_find(map, rediscovery_added[i].addr) < 0 && rom_map_allocate(map, rediscovery_added[i].addr) >= 0)
+        {
+            added = true;
+        }
+    }
 
-typedef uint8_t ds18b20_phy_addr_t[8];
+    if (changed || added)
+    {
+        rom_map_save(map);
+    }
+    free(map);
 
-typedef struct
+    if (added)
+    {
+        ESP_LOGI(TAG, "Restarting to register the endpoints of new DS18B20 devices");
+#if DS18B20_HISTORY_ENABLE
+        history_flush();
+#endif
+        esp_restart();
+    }
+}
+
+/* One ROM per call, so a pass over the buses is spread over as many cycles as there are sensors */
+static void thermometer_rediscover_step(void)
 {
+    onewire_bus_t *dev = &buses[rediscovery_bus];
     ds18b20_phy_addr_t addr;
-    int16_t value;
-    uint8_t read_attempts;
-    uint8_t skip_unchanged_updates;
-} ds18b20_t;
 
-typedef struct
-{
-    ds18b20_t ds18b20[32];
-    uint8_t count;
-} thermometer_list_t;
+    /* Alarm search runs on the same search state, the background search keeps its own progress */
+    onewire_search_state_t regular      = dev->search;
+    dev->search                         = rediscovery_search[rediscovery_bus];
+    int r                               = onewire_search(dev, ONEWIRE_CMD_SEARCH_ROM, addr);
+    rediscovery_search[rediscovery_bus] = dev->search;
+    dev->search                         = regular;
 
-static ds18b20_dev_t ds18b20_dev = {
-    .pin           = DS18B20_GPIO,
-    .parasite      = false,
-    .bitResolution = 12,
-    .search =
+    if (r > 0)
+    {
+        rediscovery_devices++;
+        if (rediscovery_search[rediscovery_bus].last_device)
         {
-            .LastDiscrepancy       = 0,
-            .LastDeviceFlag        = false,
-            .LastFamilyDiscrepancy = 0,
-            .ROM_NO                = {0},
-        },
-};
+            /* The whole bus was walked, removed and added devices change how it is addressed */
+            if (dev->devices != rediscovery_devices)
+            {
+                ESP_LOGI(TAG, "Bus %d carries %d devices, was %d", rediscovery_bus, rediscovery_devices, dev->devices);
+            }
+            dev->devices           = rediscovery_devices;
+            dev->devices_confirmed = true;
+        }
+        thermometer_rediscovered(addr, rediscovery_bus);
+        return;
+    }
+    rediscovery_devices = 0;
+    if (r < 0)
+    {
+        /* The search state was reset, the bus is walked again from its first ROM */
+        ESP_LOGD(TAG, "Background search on bus %d failed", rediscovery_bus);
+        return;
+    }
 
-static thermometer_list_t thermometer_list               = {0};
-static esp_zb_user_cb_handle_t temperature_update_handle = 0;
+    if (++rediscovery_bus < THERMOMETER_BUS_COUNT)
+    {
+        return;
+    }
+    rediscovery_bus = 0;
+    thermometer_rediscovery_pass_done();
 
-static int ds18b20_compare(const void *a, const void *b) { return memcmp(*(ds18b20_phy_addr_t *)a, *(ds18b20_phy_addr_t *)b, sizeof(ds18b20_phy_addr_t)); }
+    memset(rediscovery_seen, 0, (thermometer_list.count + 7) / 8);
+    rediscovery_added_count = 0;
+}
 
-void set_temperature_unknown(uint8_t ep)
+static void temperature_rediscover_callback(uint8_t param)
 {
-    led_driver_set(0, 0xFF, 0xFF);
-    ESP_LOGW(TAG, "Setting temperature to unknown for endpoint %d", ep);
-    esp_zb_zcl_set_attribute_val(
-        ep,
-        ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
-        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-        ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
-        &(int16_t){0x8000},  // 0x8000 is the Zigbee "invalid/measured value unknown" code, not IEEE NaN (z2m skips NaN values - bug)
-        false);
+    if (temperature_cycle_running)
+    {
+        /* An on-demand measurement took the bus, the next cycle schedules another step */
+        return;
+    }
+
+    int64_t started_us = esp_timer_get_time();
+
+    thermometer_rediscover_step();
+
+    track_stack_hold_time(started_us, "rediscover");
+}
+#endif
+
+static void temperature_schedule_next_cycle(void)
+{
+    uint32_t delay_ms         = cycle_scheduler_cycle_finished();
+    temperature_update_handle = esp_zb_scheduler_user_alarm(temperature_convert_callback, NULL, delay_ms);
+    temperature_cycle_running = false;
+
+#if DS18B20_REDISCOVERY_ENABLE
+    /* Runs as its own alarm after pending stack work, and only when the next conversion is far enough away */
+    if (rediscovery_seen != NULL && delay_ms > DS18B20_REDISCOVERY_MIN_SPARE_MS)
+    {
+        esp_zb_scheduler_alarm(temperature_rediscover_callback, 0, 1);
+    }
+#endif
+}
+
+static void temperature_reread_callback(void *param)
+{
+    int64_t started_us = esp_timer_get_time();
+
+    thermometer_reread_values();
+    thermometer_finish_cycle();
+    temperature_schedule_next_cycle();
+
+    track_stack_hold_time(started_us, "reread");
+}
+
+static void temperature_read_callback(void *param)
+{
+    int64_t started_us = esp_timer_get_time();
+
+    uint32_t reconvert_time_ms = thermometer_read_values(started_us);
+    if (reconvert_time_ms == THERMOMETER_READ_PENDING)
+    {
+        temperature_update_handle = esp_zb_scheduler_user_alarm(temperature_read_callback, NULL, 0);
+    }
+    else if (reconvert_time_ms > 0)
+    {
+        temperature_update_handle = esp_zb_scheduler_user_alarm(temperature_reread_callback, NULL, reconvert_time_ms);
+    }
+    else
+    {
+        thermometer_finish_cycle();
+        temperature_schedule_next_cycle();
+    }
+
+    track_stack_hold_time(started_us, "read");
+}
+
+static void temperature_convert_callback(void *param)
+{
+    int64_t started_us = esp_timer_get_time();
+
+    temperature_cycle_running = true;
+    cycle_scheduler_cycle_started();
+    thermometer_request_conversion();
+    temperature_update_handle = esp_zb_scheduler_user_alarm(temperature_read_callback, NULL, thermometer_conversion_time_ms());
+
+    track_stack_hold_time(started_us, "convert");
+}
+
+/* Called from the Zigbee task once the device is on the network, runs a cycle right away instead of at the next deadline */
+void thermometer_network_joined(void)
+{
+    power_set_poll_interval(device_config_get()->update_interval);
+    if (thermometer_list.count == 0)
+    {
+        return;
+    }
+
+    temperature_report_on_join = true;
+    cycle_scheduler_joined();
+    if (!temperature_cycle_running)
+    {
+        esp_zb_scheduler_user_alarm_cancel(temperature_update_handle);
+        temperature_update_handle = esp_zb_scheduler_user_alarm(temperature_convert_callback, NULL, 0);
+    }
+}
+
+static void temperature_demand_convert_callback(void *param);
+
+/* Called while no cycle runs: the periodic cycle answers the demand if it is due before a separate conversion
+   would be done, otherwise the demanded sensors are converted on their own */
+static void thermometer_start_demand(void)
+{
+    uint32_t conversion_time_ms = thermometer_demand_conversion_time_ms(&demand_pending);
+
+    esp_zb_scheduler_user_alarm_cancel(temperature_update_handle);
+    if (cycle_scheduler_next_delay() <= conversion_time_ms)
+    {
+        temperature_update_handle = esp_zb_scheduler_user_alarm(temperature_convert_callback, NULL, 0);
+    }
+    else
+    {
+        temperature_update_handle = esp_zb_scheduler_user_alarm(temperature_demand_convert_callback, NULL, 0);
+    }
 }
 
-void thermometer_update_values(void)
+static void temperature_demand_read_callback(void *param)
 {
-    led_driver_set(0, 0xFF, 0);
-    ds18b20_requestTemperatures(&ds18b20_dev);
-    led_driver_set(0, 0, 0);
+    int64_t started_us = esp_timer_get_time();
 
+    led_driver_set_status(LED_STATUS_OFF);
+    thermometer_release_pullups();
     for (uint8_t i = 0; i < thermometer_list.count; i++)
     {
-        uint8_t ep         = i + DS18B20_FIRST_ENDPOINT;
         ds18b20_t *ds18b20 = &thermometer_list.ds18b20[i];
+        if (!thermometer_demanded(&demand_active, ds18b20))
+        {
+            continue;
+        }
 
-        int32_t raw = ds18b20_getTemp(&ds18b20_dev, ds18b20->addr);
-        if (raw == DEVICE_DISCONNECTED_RAW || raw == 0)
+        thermometer_read_sensor(ds18b20, true);
+        if (demand_active.resolution != 0 && demand_active.resolution < ds18b20->resolution + 9)
         {
-            ESP_LOGW(TAG, "Failed to read temperature for endpoint %d", ep);
+            /* Automatic resolution starts over from the configured one */
+            thermometer_apply_resolution(ds18b20, ds18b20->resolution + 9);
+        }
+    }
+    thermometer_answer_demand(&demand_active);
 
-            ds18b20->read_attempts++;
-            if (ds18b20->read_attempts > DS18B20_READ_FAILURE_ATTEMPTS)
-            {
-                set_temperature_unknown(ep);
-            }
+    temperature_cycle_running = false;
+    if (demand_pending.triggered_us != 0)
+    {
+        thermometer_start_demand();
+    }
+    else
+    {
+        temperature_update_handle = esp_zb_scheduler_user_alarm(temperature_convert_callback, NULL, cycle_scheduler_next_delay());
+    }
+
+    track_stack_hold_time(started_us, "demand read");
+}
+
+/* Converts the demanded sensors only, at the requested resolution when it is lower than theirs */
+static void temperature_demand_convert_callback(void *param)
+{
+    int64_t started_us = esp_timer_get_time();
+
+    temperature_cycle_running   = true;
+    demand_active               = demand_pending;
+    demand_pending.triggered_us = 0;
+    led_driver_set_status(LED_STATUS_READING);
+
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        ds18b20_t *ds18b20 = &thermometer_list.ds18b20[i];
+        if (!thermometer_demanded(&demand_active, ds18b20))
+        {
             continue;
         }
 
-        int16_t new_value = (int16_t)((float)raw * 0.78125f);
-
-        if (abs(ds18b20->value - new_value) < 10)
+        uint8_t resolution = thermometer_demand_resolution(&demand_active, ds18b20);
+        if (resolution < ds18b20->current_resolution + 9)
         {
-            ds18b20->skip_unchanged_updates++;
-            if (ds18b20->skip_unchanged_updates > DS18B20_SKIP_UNCHANGED_UPDATE)
-            {
-                ds18b20->skip_unchanged_updates = 0;
-            }
-            else
-            {
-                continue;
-            }
+            thermometer_apply_resolution(ds18b20, resolution);
         }
-        else
+        if (demand_active.ep != 0)
+        {
+            thermometer_convert(ds18b20->bus, thermometer_address(ds18b20), ds18b20->current_resolution + 9);
+        }
+    }
+    if (demand_active.ep == 0)
+    {
+        for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT; bus++)
         {
-            ds18b20->skip_unchanged_updates = 0;
+            thermometer_convert(bus, NULL, buses[bus].resolution);
         }
+    }
+    uint32_t conversion_time_ms = thermometer_demand_conversion_time_ms(&demand_active);
+    temperature_update_handle   = esp_zb_scheduler_user_alarm(temperature_demand_read_callback, NULL, conversion_time_ms);
+
+    track_stack_hold_time(started_us, "demand convert");
+}
+
+/* Requester of a command, reports to an address that is not a short one go to the bound devices instead */
+static uint16_t thermometer_requester(const esp_zb_zcl_cmd_info_t *info)
+{
+    return info->src_address.addr_type == ESP_ZB_ZCL_ADDR_TYPE_SHORT ? info->src_address.u.short_addr : 0xFFFF;
+}
 
-        ds18b20->value = new_value;
+/* Measure command of the sensor configuration cluster: resolution u8 (0 or missing keeps the configured one),
+   flags u8 (SENSOR_CONFIG_MEASURE_ALL for every endpoint) */
+esp_err_t thermometer_handle_command(const esp_zb_zcl_custom_cluster_command_message_t *message)
+{
+    const uint8_t *payload = message->data.value;
+    uint8_t resolution     = payload && message->data.size >= 1 ? payload[0] : 0;
+    uint8_t flags          = payload && message->data.size >= 2 ? payload[1] : 0;
+    uint8_t ep             = flags & SENSOR_CONFIG_MEASURE_ALL ? 0 : message->info.dst_endpoint;
+    uint16_t dst_addr      = thermometer_requester(&message->info);
 
-        esp_zb_zcl_status_t status = esp_zb_zcl_set_attribute_val(
-            ep, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, &ds18b20->value, false);
+    ESP_RETURN_ON_FALSE(
+        message->info.command.id == SENSOR_CONFIG_CMD_MEASURE_ID, ESP_ERR_NOT_SUPPORTED, TAG, "Unknown sensor command 0x%x", message->info.command.id);
+    ESP_RETURN_ON_FALSE(thermometer_list.count > 0, ESP_ERR_INVALID_STATE, TAG, "No sensors to measure");
+    ESP_RETURN_ON_FALSE(resolution == 0 || (resolution >= 9 && resolution <= 12), ESP_ERR_INVALID_ARG, TAG, "Invalid resolution %d", resolution);
+    ESP_RETURN_ON_FALSE(ep == 0 || thermometer_find_endpoint(ep) != NULL, ESP_ERR_NOT_FOUND, TAG, "No sensor on endpoint %d", ep);
 
-        if (status != ESP_ZB_ZCL_STATUS_SUCCESS)
+    if (demand_pending.triggered_us == 0)
+    {
+        demand_pending = (thermometer_demand_t){
+            .triggered_us = esp_timer_get_time(),
+            .ep           = ep,
+            .resolution   = resolution,
+            .dst_addr     = dst_addr,
+            .dst_ep       = message->info.src_endpoint,
+        };
+    }
+    else
+    {
+        if (demand_pending.ep != ep)
         {
-            ESP_LOGW(TAG, "Failed to update temperature for endpoint %d, status: %d", ep, status);
+            demand_pending.ep = 0;
         }
-        else
+        if (demand_pending.resolution != 0 && (resolution == 0 || demand_pending.resolution < resolution))
         {
-            ESP_LOGI(TAG, "Updated temperature for endpoint %d: %i.%02i°C", ep, ds18b20->value / 100, ds18b20->value % 100);
+            demand_pending.resolution = resolution;
         }
+        if (demand_pending.dst_addr != dst_addr || demand_pending.dst_ep != message->info.src_endpoint)
+        {
+            demand_pending.dst_addr = 0xFFFF;
+        }
+        cycle_scheduler_demand_coalesced();
     }
-}
 
-static void temperature_update_callback(void *param)
-{
-    thermometer_update_values();
-    temperature_update_handle = esp_zb_scheduler_user_alarm(temperature_update_callback, NULL, DS18B20_UPDATE_INTERVAL);
+    /* A running cycle or demand answers it when it ends */
+    if (!temperature_cycle_running)
+    {
+        thermometer_start_demand();
+    }
+    return ESP_OK;
 }
 
 void thermometer_add_endpoints(void)
@@ -132,14 +1473,56 @@ void thermometer_add_endpoints(void)
 
     for (uint8_t i = 0; i < thermometer_list.count; i++)
     {
-        uint8_t ep         = i + DS18B20_FIRST_ENDPOINT;
         ds18b20_t *ds18b20 = &thermometer_list.ds18b20[i];
+        uint8_t ep         = ds18b20->endpoint;
 
-        ds18b20->value = ds18b20_getTempC(&ds18b20_dev, ds18b20->addr);
+        ds18b20->value = (int16_t)0x8000;
 
         esp_zb_temperature_sensor_cfg_t temperature_sensor_cfg = ESP_ZB_DEFAULT_TEMPERATURE_SENSOR_CONFIG();
         esp_zb_cluster_list_t *esp_zb_cluster_list             = esp_zb_temperature_sensor_clusters_create(&temperature_sensor_cfg);
 
+        uint8_t resolution                 = ds18b20->resolution + 9;
+        bool auto_resolution               = ds18b20->auto_resolution;
+        uint8_t median_size                = ds18b20->median_size;
+        uint8_t ema_shift                  = ds18b20->ema_shift;
+        uint16_t spike_threshold           = ds18b20->spike_threshold;
+        esp_zb_attribute_list_t *attr_list = esp_zb_zcl_attr_list_create(SENSOR_CONFIG_CLUSTER_ID);
+        esp_zb_custom_cluster_add_custom_attr(attr_list, SENSOR_CONFIG_ATTR_RESOLUTION_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &resolution);
+        esp_zb_custom_cluster_add_custom_attr(
+            attr_list, SENSOR_CONFIG_ATTR_AUTO_RESOLUTION_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &auto_resolution);
+        esp_zb_custom_cluster_add_custom_attr(attr_list, SENSOR_CONFIG_ATTR_MEDIAN_SIZE_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &median_size);
+        esp_zb_custom_cluster_add_custom_attr(attr_list, SENSOR_CONFIG_ATTR_EMA_SHIFT_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &ema_shift);
+        esp_zb_custom_cluster_add_custom_attr(
+            attr_list, SENSOR_CONFIG_ATTR_SPIKE_THRESHOLD_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &spike_threshold);
+        esp_zb_cluster_list_add_custom_cluster(esp_zb_cluster_list, attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+
+#if DS18B20_PACKED_REPORT_ENABLE
+        if (i == 0)
+        {
+            /* Endpoint followed by the ROM serial number, family code and CRC are implied */
+            uint8_t rom_table[PACKED_REPORT_ROM_TABLE_ENTRIES * 7];
+            uint8_t entries = thermometer_list.count < PACKED_REPORT_ROM_TABLE_ENTRIES ? thermometer_list.count : PACKED_REPORT_ROM_TABLE_ENTRIES;
+            for (uint8_t j = 0; j < entries; j++)
+            {
+                rom_table[j * 7] = thermometer_list.ds18b20[j].endpoint;
+                memcpy(&rom_table[j * 7 + 1], &thermometer_list.ds18b20[j].addr[1], 6);
+            }
+            packed_report_add_cluster(esp_zb_cluster_list, rom_table, entries * 7);
+        }
+#endif
+        if (i == 0)
+        {
+            cycle_scheduler_add_cluster(esp_zb_cluster_list);
+            device_config_add_cluster(esp_zb_cluster_list);
+#if DS18B20_HISTORY_ENABLE
+            history_add_cluster(esp_zb_cluster_list, ep);
+#endif
+#if ZB_OTA_ENABLE
+            ota_add_cluster(esp_zb_cluster_list);
+#endif
+        }
+        diagnostics_add_cluster(esp_zb_cluster_list, i == 0);
+
         esp_zb_endpoint_config_t endpoint_config = {
             .endpoint           = ep,
             .app_profile_id     = ESP_ZB_AF_HA_PROFILE_ID,
@@ -150,59 +1533,269 @@ void thermometer_add_endpoints(void)
 
         ESP_LOGI(
             TAG,
-            "Adding endpoint %d for DS18B20 device %02x-%02x%02x%02x%02x%02x%02x",
+            "Adding endpoint %d for DS18B20 device %02x-%02x%02x%02x%02x%02x%02x on bus %d",
             ep,
-            thermometer_list.ds18b20[i].addr[0],
-            thermometer_list.ds18b20[i].addr[6],
-            thermometer_list.ds18b20[i].addr[5],
-            thermometer_list.ds18b20[i].addr[4],
-            thermometer_list.ds18b20[i].addr[3],
-            thermometer_list.ds18b20[i].addr[2],
-            thermometer_list.ds18b20[i].addr[1]);
+            ds18b20->addr[0],
+            ds18b20->addr[6],
+            ds18b20->addr[5],
+            ds18b20->addr[4],
+            ds18b20->addr[3],
+            ds18b20->addr[2],
+            ds18b20->addr[1],
+            ds18b20->bus);
     }
 
     esp_zb_device_register(ep_list);
 
+    for (uint8_t i = 0; i < thermometer_list.count; i++)
+    {
+        thermometer_configure_reporting(thermometer_list.ds18b20[i].endpoint);
+    }
+
     if (thermometer_list.count > 0)
     {
-        temperature_update_handle = esp_zb_scheduler_user_alarm(temperature_update_callback, NULL, DS18B20_UPDATE_INTERVAL);
+        temperature_update_handle = esp_zb_scheduler_user_alarm(
+            temperature_convert_callback, NULL, cycle_scheduler_start(device_config_get()->update_interval, thermometer_list.ds18b20[0].endpoint));
     }
 }
 
-void thermometer_init(void)
+static bool thermometer_found_append(thermometer_found_t **found, uint8_t *found_count, uint8_t *found_capacity, const ds18b20_phy_addr_t addr, uint8_t bus)
 {
-    ds18b20_init(&ds18b20_dev, DS18B20_GPIO);
+    if (*found_count == *found_capacity)
+    {
+        uint8_t capacity = *found_capacity ? (*found_capacity > ROM_MAP_MAX_SLOTS / 2 ? ROM_MAP_MAX_SLOTS : *found_capacity * 2) : 8;
 
-    uint8_t *paddr = thermometer_list.ds18b20[0].addr;
+        thermometer_found_t *grown = realloc(*found, capacity * sizeof(thermometer_found_t));
+        if (grown == NULL)
+        {
+            ESP_LOGE(TAG, "Out of memory while collecting DS18B20 devices");
+            return false;
+        }
+        *found          = grown;
+        *found_capacity = capacity;
+    }
+
+    memcpy((*found)[*found_count].addr, addr, sizeof(ds18b20_phy_addr_t));
+    (*found)[*found_count].bus = bus;
+    (*found_count)++;
+    return true;
+}
+
+static bool thermometer_verify_rom_map(const rom_map_t *rom_map, thermometer_found_t **found, uint8_t *found_count)
+{
+    uint8_t scratchpad[DS18B20_SCRATCHPAD_SIZE];
+    uint8_t found_capacity = 0;
 
-    for (long r = ds18b20_search(&ds18b20_dev, paddr); r > 0 && thermometer_list.count < 32; r = ds18b20_search(&ds18b20_dev, paddr))
+    for (uint8_t slot = 0; slot < rom_map->count; slot++)
     {
-        if (r == 1)
+        if (rom_map_slot_is_free(rom_map, slot))
+        {
+            continue;
+        }
+
+        /* The bus is not persisted, so a sensor moved to another bus is still found here */
+        uint8_t bus = 0;
+        while (bus < THERMOMETER_BUS_COUNT && ds18b20_read_scratchpad(&buses[bus], rom_map->slots[slot], scratchpad, DS18B20_SCRATCHPAD_SIZE) != ESP_OK)
         {
-            ESP_LOGI(TAG, "Found DS18B20 device %02x-%02x%02x%02x%02x%02x%02x", paddr[0], paddr[6], paddr[5], paddr[4], paddr[3], paddr[2], paddr[1]);
-            thermometer_list.count++;
-            paddr = thermometer_list.ds18b20[thermometer_list.count].addr;
+            bus++;
         }
-        else if (r < 0)
+
+        if (bus == THERMOMETER_BUS_COUNT)
         {
-            ESP_LOGI(TAG, "Error while search DS18B20 devices: ERRNO %i", r);
-            break;
+            ESP_LOGI(TAG, "Known DS18B20 device on endpoint %d does not answer", slot + DS18B20_FIRST_ENDPOINT);
+            *found_count = 0;
+            return false;
         }
-        else
+
+        if (!thermometer_found_append(found, found_count, &found_capacity, rom_map->slots[slot], bus))
         {
-            ESP_LOGI(TAG, "All DS18B20 devices are found");
-            break;
+            *found_count = 0;
+            return false;
+        }
+    }
+
+    return *found_count > 0;
+}
+
+static void thermometer_search(thermometer_found_t **found, uint8_t *found_count)
+{
+    ds18b20_phy_addr_t addr;
+    uint8_t found_capacity = 0;
+
+    for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT && *found_count < ROM_MAP_MAX_SLOTS; bus++)
+    {
+        for (int r = onewire_search(&buses[bus], ONEWIRE_CMD_SEARCH_ROM, addr); r != 0 && *found_count < ROM_MAP_MAX_SLOTS;
+             r = onewire_search(&buses[bus], ONEWIRE_CMD_SEARCH_ROM, addr))
+        {
+            if (r == 1)
+            {
+                ESP_LOGI(TAG, "Found DS18B20 device %02x-%02x%02x%02x%02x%02x%02x on bus %d", addr[0], addr[6], addr[5], addr[4], addr[3], addr[2], addr[1], bus);
+                if (!thermometer_found_append(found, found_count, &found_capacity, addr, bus))
+                {
+                    return;
+                }
+                buses[bus].devices_confirmed = buses[bus].search.last_device;
+            }
+            else if (r < 0)
+            {
+                ESP_LOGI(TAG, "Error while search DS18B20 devices on bus %d", bus);
+                break;
+            }
+            else
+            {
+                ESP_LOGI(TAG, "All DS18B20 devices on bus %d are found", bus);
+                break;
+            }
+        }
+    }
+
+    if (*found_count == ROM_MAP_MAX_SLOTS)
+    {
+        ESP_LOGW(TAG, "Endpoint limit of %d DS18B20 devices reached, remaining devices are ignored", ROM_MAP_MAX_SLOTS);
+    }
+}
+
+static void thermometer_assign_endpoints(rom_map_t *rom_map, thermometer_found_t *found, uint8_t found_count)
+{
+    /* Nothing answered at all, most likely a bus fault: keep the stored map untouched */
+    if (found_count == 0)
+    {
+        return;
+    }
+
+    rom_map_t *new_map = malloc(sizeof(rom_map_t));
+    if (new_map == NULL)
+    {
+        ESP_LOGE(TAG, "Out of memory while assigning endpoints");
+        return;
+    }
+
+    /* Known sensors keep their slots, slots of missing sensors are released for new ones */
+    qsort(found, found_count, sizeof(thermometer_found_t), ds18b20_compare);
+    *new_map = *rom_map;
+    for (uint8_t slot = 0; slot < new_map->count; slot++)
+    {
+        if (!rom_map_slot_is_free(new_map, slot) && bsearch(new_map->slots[slot], found, found_count, sizeof(thermometer_found_t), ds18b20_compare) == NULL)
+        {
+            memset(new_map->slots[slot], 0, sizeof(ds18b20_phy_addr_t));
+        }
+    }
+    while (new_map->count > 0 && rom_map_slot_is_free(new_map, new_map->count - 1))
+    {
+        new_map->count--;
+    }
+
+    thermometer_list.ds18b20 = calloc(found_count, sizeof(ds18b20_t));
+    if (thermometer_list.ds18b20 == NULL)
+    {
+        ESP_LOGE(TAG, "Out of memory for %d DS18B20 devices", found_count);
+        free(new_map);
+        return;
+    }
+
+    /* Counted before the resolution is written below, a single device on its bus is addressed with Skip ROM */
+    for (uint8_t i = 0; i < found_count; i++)
+    {
+        buses[found[i].bus].devices++;
+    }
+
+    for (uint8_t i = 0; i < found_count; i++)
+    {
+        int slot = rom_map_find(new_map, found[i].addr);
+        if (slot < 0)
+        {
+            slot = rom_map_allocate(new_map, found[i].addr);
+        }
+
+        ds18b20_t *ds18b20 = &thermometer_list.ds18b20[thermometer_list.count++];
+        memcpy(ds18b20->addr, found[i].addr, sizeof(ds18b20_phy_addr_t));
+        ds18b20->endpoint = slot + DS18B20_FIRST_ENDPOINT;
+        ds18b20->bus      = found[i].bus;
+
+        sensor_config_t config;
+        sensor_config_load(ds18b20->endpoint, &config);
+        ds18b20->resolution      = config.resolution - 9;
+        ds18b20->auto_resolution = config.auto_resolution;
+        ds18b20->median_size     = config.median_size;
+        ds18b20->ema_shift       = config.ema_shift;
+        ds18b20->spike_threshold = config.spike_threshold;
+        thermometer_apply_resolution(ds18b20, config.resolution);
+    }
+
+    if (new_map->count != rom_map->count || memcmp(new_map->slots, rom_map->slots, new_map->count * sizeof(ds18b20_phy_addr_t)) != 0)
+    {
+        rom_map_save(new_map);
+    }
+    free(new_map);
+}
+
+void thermometer_init(void)
+{
+    thermometer_found_t *found = NULL;
+    uint8_t found_count        = 0;
+
+    device_config_load();
+
+    for (uint8_t bus = 0; bus < THERMOMETER_BUS_COUNT; bus++)
+    {
+        if (onewire_init(&buses[bus], &DS18B20_BUS_BACKEND, bus_gpios[bus]) != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Bus %d falls back to the GPIO backend", bus);
+            ESP_ERROR_CHECK(onewire_init(&buses[bus], &onewire_gpio_backend, bus_gpios[bus]));
         }
+        buses[bus].resolution = device_config_get()->resolution;
+#if DS18B20_PARASITE_POWER_ENABLE
+        buses[bus].parasite = ds18b20_parasite_powered(&buses[bus]);
+        if (buses[bus].parasite)
+        {
+            ESP_LOGI(TAG, "Bus %d has parasite-powered devices, driving it high during conversions", bus);
+        }
+#endif
+#if ZB_SLEEPY_END_DEVICE
+        /* Keep the bus pin configuration through light sleep so the pull-up keeps the bus idle high */
+        gpio_sleep_sel_dis(bus_gpios[bus]);
+#endif
+    }
+
+    rom_map_t *rom_map = malloc(sizeof(rom_map_t));
+    if (rom_map == NULL)
+    {
+        ESP_LOGE(TAG, "Out of memory for the ROM map");
+        return;
+    }
+
+    if (rom_map_load(rom_map) == ESP_OK && thermometer_verify_rom_map(rom_map, &found, &found_count))
+    {
+        ESP_LOGI(TAG, "All known DS18B20 devices answered, search skipped");
+    }
+    else
+    {
+        thermometer_search(&found, &found_count);
     }
 
+    thermometer_assign_endpoints(rom_map, found, found_count);
+    free(found);
+    free(rom_map);
+
     if (thermometer_list.count == 0)
     {
         ESP_LOGI(TAG, "No DS18B20 devices found");
-        led_driver_set(0xFF, 0, 0xFF);
+        led_driver_set_status(LED_STATUS_NO_SENSORS);
         return;
     }
 
-    ESP_LOGI(TAG, "Found %i DS18B20 devices", thermometer_list.count);
+    ESP_LOGI(TAG, "Found %i DS18B20 devices, %u bytes of RAM per device", thermometer_list.count, sizeof(ds18b20_t));
+
+    qsort(thermometer_list.ds18b20, thermometer_list.count, sizeof(ds18b20_t), ds18b20_endpoint_compare);
+
+    /* Allocated after sorting as it is indexed like the sensor arena; without it readings go unfiltered */
+    thermometer_list.filters = calloc(thermometer_list.count, sizeof(reading_filter_t));
+    if (thermometer_list.filters == NULL)
+    {
+        ESP_LOGW(TAG, "Out of memory for reading filters, readings are not filtered");
+    }
 
-    qsort(thermometer_list.ds18b20, thermometer_list.count, sizeof(ds18b20_t), ds18b20_compare);
+#if DS18B20_REDISCOVERY_ENABLE
+    rediscovery_seen = calloc((thermometer_list.count + 7) / 8, 1);
+#endif
 }
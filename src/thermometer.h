@@ -9,9 +9,27 @@ extern "C"
 {
 #endif
 
+    typedef struct
+    {
+        uint32_t cycles;           /* Completed measurement cycles */
+        uint32_t bus_time_us;      /* 1-Wire bus time spent in the last cycle */
+        uint16_t attribute_writes; /* ZCL attribute writes issued in the last cycle */
+        uint16_t read_failures;    /* Failed sensor reads in the last cycle */
+        uint32_t pullup_time_us;   /* Strong pullup time on parasite-powered buses in the last cycle */
+        uint32_t pullup_late_us;   /* Longest strong pullup past the conversion time since boot */
+        uint32_t bus_cpu_ns;       /* 1-Wire backend CPU time per byte since boot */
+        uint32_t bus_slots;        /* 1-Wire time slots used in the last cycle, resets not included */
+        uint32_t bus_resets;       /* 1-Wire reset sequences in the last cycle */
+        uint32_t stack_hold_us;    /* Longest single alarm of the last cycle in the Zigbee task */
+    } thermometer_stats_t;
+
     void thermometer_add_endpoints();
     void thermometer_init(void);
-    void thermometer_update_values(void);
+    void thermometer_request_conversion(void);
+    void thermometer_network_joined(void);
+    const thermometer_stats_t *thermometer_get_stats(void);
+    esp_err_t thermometer_set_attribute(const esp_zb_zcl_set_attr_value_message_t *message);
+    esp_err_t thermometer_handle_command(const esp_zb_zcl_custom_cluster_command_message_t *message);
 
 #ifdef __cplusplus
 }